@@ -1,3 +1,4 @@
+import itertools
 import random
 import sys
 import os
@@ -8,55 +9,28 @@ from typing import List, Tuple
 sys.path.append(os.path.dirname(__file__))
 
 from code.gf2 import (
-    mat_inv,
-    mat_vec_mul,
-    weight,
+    PackedMatrix,
+    bits_to_int,
+    int_to_bits,
+    pack_matrix,
+    packed_inv,
+    packed_mul,
+    packed_permute_columns,
+    packed_vec_mul,
+    parity,
+    permute_bits,
+    popcount,
     Matrix,
     BitVector
 )
 # 引入 Hamming 方案用于生成测试数据
 from code.hamming_mceliece.hamming_code import HammingMcEliece
 
-def get_submatrix(G: Matrix, columns: List[int]) -> Matrix:
+def generate_error_masks(n: int, t: int) -> List[int]:
     """
-    从矩阵 G 中提取指定的列构成子矩阵
+    生成所有重量为 t 的错误向量，用整数位掩码表示，按位置组合的字典序排列
     """
-    return [[row[c] for c in columns] for row in G]
-
-def get_subvector(vec: BitVector, columns: List[int]) -> BitVector:
-    """
-    从向量 vec 中提取指定的列
-    """
-    return [vec[c] for c in columns]
-
-def generate_error_vectors(n: int, t: int) -> List[BitVector]:
-    """
-    生成所有重量为 t 的错误向量
-    """
-    result = []
-    
-    def backtrack(pos: int, remaining: int, current: List[int]):
-        if remaining == 0:
-            # 生成完整的错误向量
-            vec = [0] * n
-            for idx in current:
-                vec[idx] = 1
-            result.append(vec)
-            return
-        
-        if pos + remaining > n:
-            return
-        
-        # 选择当前位置
-        current.append(pos)
-        backtrack(pos + 1, remaining - 1, current)
-        current.pop()
-        
-        # 不选择当前位置
-        backtrack(pos + 1, remaining, current)
-    
-    backtrack(0, t, [])
-    return result
+    return [sum(1 << i for i in combo) for combo in itertools.combinations(range(n), t)]
 
 def isd_mmt(G_pub: Matrix, c: BitVector, t: int, max_iter: int = 100000) -> Tuple[BitVector, bool, int]:
     """
@@ -78,80 +52,60 @@ def isd_mmt(G_pub: Matrix, c: BitVector, t: int, max_iter: int = 100000) -> Tupl
     print(f"    参数: n={n}, k={k}, t={t}")
     print(f"    最大尝试次数: {max_iter}")
 
+    # 公钥和密文只压缩一次，之后的矩阵运算都在按行压缩的形式上做（大矩阵走 M4RI）
+    G_packed = pack_matrix(G_pub)
+    c_int = bits_to_int(c)
+
     for attempt in range(1, max_iter + 1):
         # 1. 随机选取 k 个列索引 (信息集 I)
         I = random.sample(range(n), k)
-        J = [j for j in range(n) if j not in I]
+        I_set = set(I)
+        J = [j for j in range(n) if j not in I_set]
         m = len(J)  # J的长度为n-k
         
         # 2. 提取子矩阵 G_I 和 G_J
-        G_I = get_submatrix(G_pub, I)
-        G_J = get_submatrix(G_pub, J)
+        G_I = packed_permute_columns(G_packed, I)
+        G_J = packed_permute_columns(G_packed, J)
         
         try:
             # 3. 计算 G_I 的逆矩阵
             if attempt % 100 == 0:
                 print(f"    尝试次数: {attempt}, 处理信息集: {I[:5]}...", end='\r')
-            G_I_inv = mat_inv(G_I)
+            G_I_inv = packed_inv(G_I)
             
             # 4. 计算变换后的矩阵 G_J' = G_I^{-1} * G_J
             # G_I_inv 是 k x k 矩阵，G_J 是 k x (n-k) 矩阵
             # 结果 G_J_prime 应该是 k x (n-k) 矩阵
-            G_J_prime = []
-            for i in range(k):
-                row = [0] * m  # m = n - k
-                for j in range(m):
-                    dot = 0
-                    for l in range(k):
-                        dot ^= G_I_inv[i][l] & G_J[l][j]
-                    row[j] = dot
-                G_J_prime.append(row)
+            G_J_prime = packed_mul(G_I_inv, G_J)
             
             # 5. 划分密文向量 c
-            c_I = get_subvector(c, I)
-            c_J = get_subvector(c, J)
+            c_I = permute_bits(c_int, I)
+            c_J = permute_bits(c_int, J)
             
             # 6. 计算 c' = G_I^{-1} * c_I
-            c_prime = [0] * k
-            for i in range(k):
-                dot = 0
-                for j in range(k):
-                    dot ^= G_I_inv[i][j] & c_I[j]
-                c_prime[i] = dot
+            c_prime = 0
+            for i, row in enumerate(G_I_inv.rows):
+                c_prime |= parity(row & c_I) << i
             
             # 7. MMT 算法的核心：将错误向量拆分
-            # 将 I 划分为 A 和 B，J 划分为 C 和 D
-            # 这里简化实现，将 A 设为前 k//2 个位置，B 设为后 k - k//2 个位置
+            # 这里简化实现，将 I 的前 k//2 个位置设为 A，后 k - k//2 个位置设为 B
             split_k = k // 2
-            A_indices = I[:split_k]
-            B_indices = I[split_k:]
             
-            # 将 J 划分为 C 和 D，对应 G_J_prime 的划分
+            # 将 J 划分为 C 和 D，对应 G_J_prime 的列划分
             split_m = m // 2
-            C_indices = J[:split_m]
-            D_indices = J[split_m:]
+            mask_A = (1 << split_m) - 1
             
-            G_A_prime = get_submatrix(G_J_prime, list(range(split_m)))
-            G_B_prime = get_submatrix(G_J_prime, list(range(split_m, m)))
+            G_A_prime = PackedMatrix([row & mask_A for row in G_J_prime.rows], split_m)
+            G_B_prime = PackedMatrix([row >> split_m for row in G_J_prime.rows], m - split_m)
             
-            c_A = get_subvector(c_J, list(range(split_m)))
-            c_B = get_subvector(c_J, list(range(split_m, m)))
+            c_A = c_J & mask_A
+            c_B = c_J >> split_m
             
             # 8. 计算 c'_A = c_A + c_prime * G_A_prime
-            c_prime_A = [0] * split_m
-            for i in range(split_m):
-                dot = 0
-                for j in range(k):
-                    dot ^= c_prime[j] & G_A_prime[j][i]
-                c_prime_A[i] = c_A[i] ^ dot
+            c_prime_A = c_A ^ packed_vec_mul(c_prime, G_A_prime)
             
             # 计算 c'_B = c_B + c_prime * G_B_prime
-            c_prime_B = [0] * (m - split_m)
-            for i in range(m - split_m):
-                dot = 0
-                for j in range(k):
-                    dot ^= c_prime[j] & G_B_prime[j][i]
-                c_prime_B[i] = c_B[i] ^ dot
+            c_prime_B = c_B ^ packed_vec_mul(c_prime, G_B_prime)
             
             # 9. 确定各部分错误向量的重量分配
             # 这里简化实现，尝试多种重量分配
@@ -163,98 +117,57 @@ def isd_mmt(G_pub: Matrix, c: BitVector, t: int, max_iter: int = 100000) -> Tupl
                     if t_D < 0 or t_D > (m - split_m):
                         continue
                     
-                    # 10. 生成所有可能的 e_A
-                    e_A_candidates = generate_error_vectors(split_k, t_A)
-                    
-                    # 11. 生成列表 A: (e_A * G_A_prime + c'_A, e_A)
-                    list_A = []
-                    for e_A in e_A_candidates:
-                        # 计算 e_A * G_A_prime
-                        product = [0] * split_m
-                        for i in range(split_m):
-                            dot = 0
-                            for j in range(split_k):
-                                dot ^= e_A[j] & G_A_prime[j][i]
-                            product[i] = dot
-                        
-                        # 计算 e_A * G_A_prime + c'_A
-                        key = [a ^ b for a, b in zip(product, c_prime_A)]
-                        list_A.append((tuple(key), e_A))
-                    
-                    # 12. 生成所有可能的 e_B
-                    e_B_candidates = generate_error_vectors(k - split_k, t_B)
+                    # 10-11. 生成所有可能的 e_A 及列表 A: (e_A * G_A_prime + c'_A, e_A)
+                    list_A = [(packed_vec_mul(e_A, G_A_prime) ^ c_prime_A, e_A)
+                              for e_A in generate_error_masks(split_k, t_A)]
                     
-                    # 13. 生成列表 B: (e_B * G_B_prime + c'_B, e_B)
-                    list_B = []
-                    for e_B in e_B_candidates:
-                        # 计算 e_B * G_B_prime
-                        product = [0] * (m - split_m)
-                        for i in range(m - split_m):
-                            dot = 0
-                            for j in range(k - split_k):
-                                dot ^= e_B[j] & G_B_prime[j][i]
-                            product[i] = dot
-                        
-                        # 计算 e_B * G_B_prime + c'_B
-                        key = [a ^ b for a, b in zip(product, c_prime_B)]
-                        list_B.append((tuple(key), e_B))
+                    # 12-13. 生成所有可能的 e_B 及列表 B: (e_B * G_B_prime + c'_B, e_B)
+                    list_B = [(packed_vec_mul(e_B, G_B_prime) ^ c_prime_B, e_B)
+                              for e_B in generate_error_masks(k - split_k, t_B)]
                     
                     # 14. 查找碰撞
-                    # 将列表 A 转换为字典以便快速查找
-                    dict_A = {key: e_A for key, e_A in list_A}
+                    # 将列表 A 转换为字典以便快速查找；
+                    # 键按位长区分，m 为奇数时 A、B 两侧的键长度不同，不会碰撞
+                    dict_A = {key: e_A for key, e_A in list_A} if split_m == m - split_m else {}
                     
                     for key_B, e_B in list_B:
                         if key_B in dict_A:
                             e_A = dict_A[key_B]
                             
                             # 15. 构建完整的 e_I
-                            e_I = e_A + e_B
+                            e_I = e_A | (e_B << split_k)
                             
                             # 16. 计算 e_J
                             # e_J = e_I * G_J_prime + (c_J + c_prime * G_J_prime)
-                            e_J = [0] * m
-                            for i in range(m):
-                                dot = 0
-                                for j in range(k):
-                                    dot ^= e_I[j] & G_J_prime[j][i]
-                                if i < split_m:
-                                    e_J[i] = dot ^ c_J[i] ^ c_prime_A[i]
-                                else:
-                                    e_J[i] = dot ^ c_J[i] ^ c_prime_B[i - split_m]
+                            e_J = packed_vec_mul(e_I, G_J_prime) ^ c_J ^ (c_prime_A | (c_prime_B << split_m))
                             
                             # 17. 验证 e_J 的重量是否为 t_C + t_D
-                            if weight(e_J) != t_C + t_D:
+                            if popcount(e_J) != t_C + t_D:
                                 continue
                             
-                            # 18. 构建完整的错误向量 e
-                            e = [0] * n
+                            # 18-19. 构建完整的错误向量 e 并验证总重量
+                            if popcount(e_I) + popcount(e_J) != t:
+                                continue
+                            e = 0
                             for i, idx in enumerate(I):
-                                e[idx] = e_I[i]
+                                if (e_I >> i) & 1:
+                                    e |= 1 << idx
                             for i, idx in enumerate(J):
-                                e[idx] = e_J[i]
-                            
-                            # 19. 验证错误向量的总重量
-                            if weight(e) != t:
-                                continue
+                                if (e_J >> i) & 1:
+                                    e |= 1 << idx
                             
                             # 20. 计算候选明文 m = (c - e) * G_I^{-1}
-                            c_minus_e = [a ^ b for a, b in zip(c, e)]
-                            c_minus_e_I = get_subvector(c_minus_e, I)
-                            
-                            m_candidate = [0] * k
-                            for i in range(k):
-                                dot = 0
-                                for j in range(k):
-                                    dot ^= c_minus_e_I[j] & G_I_inv[i][j]
-                                m_candidate[i] = dot
+                            c_minus_e_I = permute_bits(c_int ^ e, I)
+                            m_candidate = 0
+                            for i, row in enumerate(G_I_inv.rows):
+                                m_candidate |= parity(row & c_minus_e_I) << i
                             
                             # 21. 最终验证
-                            c_recalc = mat_vec_mul(m_candidate, G_pub)
-                            e_candidate = [c[i] ^ c_recalc[i] for i in range(n)]
+                            c_recalc = packed_vec_mul(m_candidate, G_packed)
                             
-                            if weight(e_candidate) == t:
+                            if popcount(c_int ^ c_recalc) == t:
                                 print(f"[+] 攻击成功! 在第 {attempt} 次尝试找到解。")
-                                return m_candidate, True, attempt
+                                return int_to_bits(m_candidate, k), True, attempt
             
         except ValueError:
             # 矩阵不可逆，跳过本次尝试
@@ -1,19 +1,31 @@
+import itertools
 import random
-from dataclasses import dataclass
-from typing import Dict, List, Tuple
+from dataclasses import dataclass, field
+from typing import List, Optional, Tuple
 
 from code.gf2 import (
     BitVector,
     Matrix,
+    PackedMatrix,
     apply_permutation,
-    apply_permutation_matrix,
-    mat_inv,
-    mat_mul,
-    mat_vec_mul,
+    bits_to_int,
+    block_interleave,
+    error_patterns,
+    gray_code_table,
+    int_to_bits,
     pack_bits,
-    random_invertible_matrix,
+    pack_matrix,
+    packed_block_systematic,
+    packed_mul,
+    packed_mul_block_diagonal,
+    packed_permute_columns,
+    packed_transpose,
+    packed_vec_mul,
+    random_invertible_pair,
     random_permutation,
+    unpack_matrix,
 )
+from code.keyfile import BitRows, check_shape, decode_key, encode_key, map_file, save_bytes
 
 # (15,7) BCH, t=2, g(x)=x^8 + x^7 + x^6 + x^4 + 1
 N = 15
@@ -63,41 +75,59 @@ def poly_to_bits(p: int, length: int) -> BitVector:
     return [(p >> i) & 1 for i in range(length)]
 
 
+# 消息 -> 码字的 2^7 项表：m(x) 对应 m(x)·g(x)
+ENCODE_TABLE = gray_code_table([G_POLY << i for i in range(K)])
+
+
+def encode_block_int(msg: int) -> int:
+    return ENCODE_TABLE[msg]
+
+
+def encode_blocks_int(msg: int, L: int) -> int:
+    # 逐块取 7 位查表，码字按块拼回整数，不展开成列表
+    code = 0
+    for blk in range(L):
+        code |= ENCODE_TABLE[msg & ((1 << K) - 1)] << (N * blk)
+        msg >>= K
+    return code
+
+
 def encode_block(msg7: BitVector) -> BitVector:
     if len(msg7) != K:
         raise ValueError("消息块必须 7 比特")
-    m = 0
-    for i, b in enumerate(msg7):
-        if b:
-            m |= 1 << i
-    code_poly = poly_mul(m, G_POLY)
-    return poly_to_bits(code_poly, N)
+    return int_to_bits(ENCODE_TABLE[bits_to_int(msg7)], N)
+
+
+# 按字节求余式（CRC 式）：15 位的 v = hi·x^8 + lo，lo 的次数小于 8 本身就是余式，
+# 只需查 hi·x^8 mod g(x)，一次查表加一次异或
+CRC_TABLE = [poly_divmod(hi << 8, G_POLY)[1] for hi in range(1 << (N - 8))]
+
+
+def remainder_int(v: int) -> int:
+    return CRC_TABLE[v >> 8] ^ (v & 0xFF)
 
 
 def compute_syndrome_vec(vec: BitVector) -> int:
-    poly = 0
-    for i, b in enumerate(vec):
-        if b:
-            poly |= 1 << i
-    _, rem = poly_divmod(poly, G_POLY)
-    return rem
-
-
-def syndrome_table(t: int) -> Dict[int, BitVector]:
-    table: Dict[int, BitVector] = {0: [0] * N}
-    for i in range(N):
-        e = [0] * N
-        e[i] = 1
-        table.setdefault(compute_syndrome_vec(e), e)
-    if t >= 2:
-        for i in range(N):
-            for j in range(i + 1, N):
-                e = [0] * N
-                e[i] = e[j] = 1
-                table.setdefault(compute_syndrome_vec(e), e)
+    return remainder_int(bits_to_int(vec))
+
+
+def syndrome_table(t: int) -> List[int]:
+    # 余式 -> 15 位错误掩码的扁平表（256 项），-1 表示超出纠错能力。
+    # 单错总是收录，t>=2 时再收录双错；同一余式保留先出现的图样
+    table = [-1] * (1 << (N - K))
+    table[0] = 0
+    for e in error_patterns(N, 2 if t >= 2 else 1)[1:]:
+        syn = remainder_int(e)
+        if table[syn] < 0:
+            table[syn] = e
     return table
 
 
+def base_syndrome_columns() -> List[int]:
+    # 单块校验矩阵按列给出：第 j 位出错时伴随式为 x^j mod g(x)，与 compute_syndrome_vec 一致
+    return [poly_divmod(1 << j, G_POLY)[1] for j in range(N)]
+
+
 def parity_check_matrix() -> Matrix:
     rows: Matrix = []
     h = H_POLY
@@ -109,40 +139,64 @@ def parity_check_matrix() -> Matrix:
     return rows
 
 
-def decode_block(r: BitVector, synd_table: Dict[int, BitVector]) -> Tuple[BitVector, bool]:
+def _byte_tables(f) -> Tuple[List[int], List[int]]:
+    # f 对 15 位整数是线性的，拆成低 8 位和高 7 位两张表，查两次表再异或即可
+    return [f(v) for v in range(256)], [f(v << 8) for v in range(128)]
+
+
+def _message_table() -> List[int]:
+    # 码字 c(x) 到消息 c(x)/g(x) 的 2^15 项表；除法的商是线性的，用两张字节表拼出全部项
+    lo, hi = _byte_tables(lambda v: poly_divmod(v, G_POLY)[0])
+    return [lo[v & 0xFF] ^ hi[v >> 8] for v in range(1 << N)]
+
+
+MSG_TABLE = _message_table()
+
+
+def decode_block_int(v: int, synd_table: List[int]) -> Tuple[int, bool]:
+    # v 的第 j 位是块内第 j 位：查余式表得到错误掩码，异或后再查码字表得到 7 位消息
+    e = synd_table[CRC_TABLE[v >> 8] ^ (v & 0xFF)]
+    if e < 0:
+        return v & ((1 << K) - 1), False
+    return MSG_TABLE[v ^ e], True
+
+
+def decode_blocks_int(v: int, L: int, synd_table: List[int]) -> Tuple[int, bool]:
+    # 逐块从整数低位取 15 位译码，译出的 7 位消息按块拼回整数
+    d = 0
+    success = True
+    block_mask = (1 << N) - 1
+    for blk in range(L):
+        msg, ok = decode_block_int(v & block_mask, synd_table)
+        v >>= N
+        d |= msg << (K * blk)
+        success = success and ok
+    return d, success
+
+
+def decode_block(r: BitVector, synd_table: List[int]) -> Tuple[BitVector, bool]:
     if len(r) != N:
         raise ValueError("码长必须 15 比特")
-    syn = compute_syndrome_vec(r)
-    if syn not in synd_table:
-        return r[:K], False
-    e = synd_table[syn]
-    c = [r[i] ^ e[i] for i in range(N)]
-    c_poly = 0
-    for i, b in enumerate(c):
-        if b:
-            c_poly |= 1 << i
-    msg, rem = poly_divmod(c_poly, G_POLY)
-    return poly_to_bits(msg, K), rem == 0
+    msg, ok = decode_block_int(bits_to_int(r), synd_table)
+    return int_to_bits(msg, K), ok
+
+
+def base_generator_packed() -> PackedMatrix:
+    return PackedMatrix([ENCODE_TABLE[1 << i] for i in range(K)], N)
 
 
 def base_generator() -> Matrix:
-    rows: Matrix = []
-    for i in range(K):
-        msg = [1 if j == i else 0 for j in range(K)]
-        rows.append(encode_block(msg))
-    return rows
+    return unpack_matrix(base_generator_packed())
 
 
 def block_generator(L: int) -> Matrix:
-    base = base_generator()
-    k, n = K * L, N * L
-    G = [[0] * n for _ in range(k)]
-    for blk in range(L):
-        for r in range(K):
-            row_idx = blk * K + r
-            for c, v in enumerate(base[r]):
-                G[row_idx][blk * N + c] = v
-    return G
+    n = N * L
+    return [int_to_bits(encode_blocks_int(1 << i, L), n) for i in range(K * L)]
+
+
+# 密钥文件中的类型字节，加载时据此拒绝别的方案或另一半密钥
+KEYFILE_PUBLIC = 3
+KEYFILE_PRIVATE = 4
 
 
 @dataclass
@@ -153,30 +207,80 @@ class PublicKey:
     L: int
     errors_per_block: int
     P: List[int]
+    # G_pub 的按行压缩形式，加密时直接按明文的 1 位异或对应行；keygen 会顺手填上
+    G_packed: Optional[PackedMatrix] = field(default=None, repr=False, compare=False)
+    # 系统形式公钥 [I_k | R]：G_pub 只存 k×(n-k) 的 R，密文前 k 位就是明文
+    systematic: bool = False
+
+    def packed(self) -> PackedMatrix:
+        if self.G_packed is None:
+            self.G_packed = pack_matrix(self.G_pub)
+        return self.G_packed
+
+    def serialize(self) -> bytes:
+        fields = [self.n, self.k, self.L, self.errors_per_block, int(self.systematic)]
+        return encode_key(KEYFILE_PUBLIC, fields, self.P, self.packed())
+
+    @classmethod
+    def deserialize(cls, data) -> "PublicKey":
+        # 矩阵行直接引用 data 的内存，G_pub 只在按列表访问时逐行展开
+        fields, P, G_packed = decode_key(data, KEYFILE_PUBLIC, 5)
+        n, k, L, errors_per_block, systematic = fields
+        if (n, k) != (N * L, K * L):
+            raise ValueError("公钥尺寸与分块数不符")
+        check_shape(P, G_packed, n, k, n - k if systematic else n)
+        return cls(BitRows(G_packed), n, k, L, errors_per_block, P, G_packed, bool(systematic))
+
+    def save(self, path: str) -> None:
+        save_bytes(path, self.serialize())
+
+    @classmethod
+    def load(cls, path: str) -> "PublicKey":
+        return cls.deserialize(map_file(path))
 
     def serialize_size(self) -> int:
-        size_G = len(pack_bits([b for row in self.G_pub for b in row]))
-        size_P = len(self.P) * 2
-        return size_G + size_P
+        return len(self.serialize())
 
 
 @dataclass
 class PrivateKey:
     S_inv: Matrix
     P_inv: List[int]
-    synd_table: Dict[int, BitVector]
+    synd_table: List[int]
     L: int
     errors_per_block: int
+    # S_inv 的按行压缩形式，批量解密时一次矩阵乘法还原全部明文；keygen 会顺手填上
+    S_packed: Optional[PackedMatrix] = field(default=None, repr=False, compare=False)
+
+    def packed(self) -> PackedMatrix:
+        if self.S_packed is None:
+            self.S_packed = pack_matrix(self.S_inv)
+        return self.S_packed
+
+    def serialize(self) -> bytes:
+        return encode_key(KEYFILE_PRIVATE, [self.L, self.errors_per_block], self.P_inv, self.packed())
+
+    @classmethod
+    def deserialize(cls, data) -> "PrivateKey":
+        fields, P_inv, S_packed = decode_key(data, KEYFILE_PRIVATE, 2)
+        L, errors_per_block = fields
+        check_shape(P_inv, S_packed, N * L, K * L, K * L)
+        # 伴随式表只由 errors_per_block 决定，不写进文件，加载时重建
+        return cls(BitRows(S_packed), P_inv, syndrome_table(errors_per_block), L, errors_per_block, S_packed)
+
+    def save(self, path: str) -> None:
+        save_bytes(path, self.serialize())
+
+    @classmethod
+    def load(cls, path: str) -> "PrivateKey":
+        return cls.deserialize(map_file(path))
 
     def serialize_size(self) -> int:
-        size_S = len(pack_bits([b for row in self.S_inv for b in row]))
-        size_P = len(self.P_inv) * 2
-        size_table = sum(2 + len(pack_bits(v)) for v in self.synd_table.values())
-        return size_S + size_P + size_table
+        return len(self.serialize())
 
 
 class BCHMcEliece:
-    def __init__(self, L: int, errors_per_block: int = T, rng=random):
+    def __init__(self, L: int, errors_per_block: int = T, rng=random, systematic: bool = False):
         if errors_per_block > T:
             raise ValueError("BCH(15,7) 最多纠正 2 比特")
         self.L = L
@@ -184,20 +288,47 @@ class BCHMcEliece:
         self.n = N * L
         self.k = K * L
         self.rng = rng
-        self._G = block_generator(L)
+        self.systematic = systematic
+        # 只保存单块生成矩阵，S·G 按块对角结构在交错列序上计算
+        self._G_base = base_generator_packed()
+        self._msg_order = block_interleave(K, L)
+        self._code_order = block_interleave(N, L)
         self._synd_table = syndrome_table(errors_per_block)
 
     def keygen(self) -> Tuple[PublicKey, PrivateKey]:
-        S = random_invertible_matrix(self.k)
-        S_inv = mat_inv(S)
+        if self.systematic:
+            return self._keygen_systematic()
+        # 在按行压缩的矩阵上完成求逆、乘法和列置换，最后再展开成公开的列表形式
+        # S 直接按交错列序采样（相当于对随机 S 再做一次列置换，分布不变），
+        # 换回分块顺序只需重排 S^-1 的行，并把交错顺序并入公钥的列置换
+        S, S_inv_packed = random_invertible_pair(self.k)
+        S_inv_packed = PackedMatrix([S_inv_packed.rows[i] for i in self._msg_order], self.k)
+        S_inv = unpack_matrix(S_inv_packed)
+        P = random_permutation(self.n)
+        P_inv = [0] * self.n
+        for i, p in enumerate(P):
+            P_inv[p] = i
+        SG = packed_mul_block_diagonal(S, self._G_base, self.L)
+        G_packed = packed_permute_columns(SG, [self._code_order[p] for p in P])
+        G_pub = unpack_matrix(G_packed)
+        return (
+            PublicKey(G_pub, self.n, self.k, self.L, self.errors_per_block, P, G_packed),
+            PrivateKey(S_inv, P_inv, self._synd_table, self.L, self.errors_per_block, S_inv_packed),
+        )
+
+    def _keygen_systematic(self) -> Tuple[PublicKey, PrivateKey]:
+        # 系统形式与 S 无关，直接由 G·P 逐块求出；列置换并入信息集在前的新列序，
+        # 私钥的 S_inv 换成把各块译出的消息还原成明文的块对角矩阵
         P = random_permutation(self.n)
+        R, order, restore = packed_block_systematic(self._G_base, self.L, P)
+        P = [P[t] for t in order]
         P_inv = [0] * self.n
         for i, p in enumerate(P):
             P_inv[p] = i
-        G_pub = apply_permutation_matrix(mat_mul(S, self._G), P)
+        S_inv = unpack_matrix(restore)
         return (
-            PublicKey(G_pub, self.n, self.k, self.L, self.errors_per_block, P),
-            PrivateKey(S_inv, P_inv, self._synd_table, self.L, self.errors_per_block),
+            PublicKey(unpack_matrix(R), self.n, self.k, self.L, self.errors_per_block, P, R, systematic=True),
+            PrivateKey(S_inv, P_inv, self._synd_table, self.L, self.errors_per_block, restore),
         )
 
     def _sample_error_private(self) -> BitVector:
@@ -212,22 +343,193 @@ class BCHMcEliece:
     def encrypt(self, m_bits: BitVector, pub: PublicKey) -> BitVector:
         if len(m_bits) != pub.k:
             raise ValueError(f"明文长度必须 {pub.k}")
-        u = mat_vec_mul(m_bits, pub.G_pub)
+        m_int = bits_to_int(m_bits)
+        if pub.systematic:
+            u = m_int | (packed_vec_mul(m_int, pub.packed()) << pub.k)
+        else:
+            u = packed_vec_mul(m_int, pub.packed())
         e_private = self._sample_error_private()
         e_public = apply_permutation(e_private, pub.P)
-        return [(u[i] ^ e_public[i]) for i in range(pub.n)]
+        return int_to_bits(u ^ bits_to_int(e_public), pub.n)
+
+    def encrypt_batch(self, messages: List[BitVector], pub: PublicKey) -> List[BitVector]:
+        # N 条明文叠成 N×k 的压缩矩阵，一次矩阵乘法得到全部码字（N 达到 M4RI_MIN 时走 M4RI / numpy 内核）
+        for m_bits in messages:
+            if len(m_bits) != pub.k:
+                raise ValueError(f"明文长度必须 {pub.k}")
+        M = PackedMatrix([bits_to_int(m_bits) for m_bits in messages], pub.k)
+        if pub.systematic:
+            U = [m | (r << pub.k) for m, r in zip(M.rows, packed_mul(M, pub.packed()).rows)]
+        else:
+            U = packed_mul(M, pub.packed()).rows
+        E = self._sample_errors_public(len(messages), pub.P)
+        return [int_to_bits(u ^ e, pub.n) for u, e in zip(U, E)]
+
+    def _sample_errors_public(self, count: int, P: List[int]) -> List[int]:
+        # 一次抽出 count 条消息全部块的错误图样：每块在 errors_per_block 元组合中等概率取一个，
+        # 与逐块洗牌取前几位同分布；错误位置直接换到公开位置，按字符串一次拼出整数
+        P_inv = [0] * self.n
+        for i, p in enumerate(P):
+            P_inv[p] = i
+        combos = list(itertools.combinations(range(N), self.errors_per_block))
+        picks = self.rng.choices(combos, k=count * self.L)
+        n = self.n
+        blank = b"0" * n
+        out = []
+        for c in range(count):
+            chars = bytearray(blank)
+            for blk, combo in enumerate(picks[c * self.L : (c + 1) * self.L]):
+                for off in combo:
+                    chars[n - 1 - P_inv[blk * N + off]] = 49  # "1"
+            out.append(int(chars, 2))
+        return out
 
     def decrypt(self, c_bits: BitVector, pub: PublicKey, priv: PrivateKey) -> Tuple[BitVector, bool]:
         if len(c_bits) != pub.n:
             raise ValueError(f"密文长度必须 {pub.n}")
-        c_perm = apply_permutation(c_bits, priv.P_inv)
-        decoded: BitVector = []
+        c_perm = bits_to_int(apply_permutation(c_bits, priv.P_inv))
+        decoded, success = decode_blocks_int(c_perm, pub.L, priv.synd_table)
+        m = packed_vec_mul(decoded, priv.packed())
+        return int_to_bits(m, pub.k), success
+
+    def decrypt_batch(
+        self, ciphertexts: List[BitVector], pub: PublicKey, priv: PrivateKey
+    ) -> List[Tuple[BitVector, bool]]:
+        # 全部密文叠成 N×n 矩阵一次逆置换，逐块查整数表译码，译出的 N×k 矩阵再一次乘 S_inv
+        for c_bits in ciphertexts:
+            if len(c_bits) != pub.n:
+                raise ValueError(f"密文长度必须 {pub.n}")
+        C = packed_permute_columns(PackedMatrix([bits_to_int(c) for c in ciphertexts], pub.n), priv.P_inv)
+        decoded = []
+        flags = []
+        for row in C.rows:
+            d, success = decode_blocks_int(row, pub.L, priv.synd_table)
+            decoded.append(d)
+            flags.append(success)
+        M = packed_mul(PackedMatrix(decoded, pub.k), priv.packed())
+        return [(int_to_bits(m, pub.k), ok) for m, ok in zip(M.rows, flags)]
+
+
+# Niederreiter 变体：公钥是打乱的校验矩阵，密文是长度 n-k 的伴随式，明文编码在每块的错误图样里
+SYN_BITS = N - K
+
+
+@dataclass
+class NiederreiterPublicKey:
+    H_pub: Matrix
+    n: int
+    r: int
+    L: int
+    errors_per_block: int
+    msg_bits: int
+    P: List[int]
+    # H_pub 的列按私有位置排好（第 p 项是公开第 P^-1[p] 列），加密时按错误位置直接取列异或
+    cols: Optional[List[int]] = field(default=None, repr=False, compare=False)
+
+    def columns(self) -> List[int]:
+        if self.cols is None:
+            public = packed_transpose(pack_matrix(self.H_pub)).rows
+            self.cols = [0] * self.n
+            for i, p in enumerate(self.P):
+                self.cols[p] = public[i]
+        return self.cols
+
+    def serialize_size(self) -> int:
+        size_H = len(pack_bits([b for row in self.H_pub for b in row]))
+        size_P = len(self.P) * 2
+        return size_H + size_P
+
+
+@dataclass
+class NiederreiterPrivateKey:
+    # 解密时把伴随式行向量右乘 M_inv 还原成各块的伴随式，再查 synd_table 得到错误图样
+    M_inv: Matrix
+    synd_table: List[int]
+    L: int
+    errors_per_block: int
+    M_packed: Optional[PackedMatrix] = field(default=None, repr=False, compare=False)
+
+    def packed(self) -> PackedMatrix:
+        if self.M_packed is None:
+            self.M_packed = pack_matrix(self.M_inv)
+        return self.M_packed
+
+    def serialize_size(self) -> int:
+        size_M = len(pack_bits([b for row in self.M_inv for b in row]))
+        size_table = len(self.synd_table) * 2
+        return size_M + size_table
+
+
+class BCHNiederreiter:
+    def __init__(self, L: int, errors_per_block: int = T, rng=random):
+        if not 1 <= errors_per_block <= T:
+            raise ValueError("BCH(15,7) 的 Niederreiter 变体每块编码 1 到 2 个错误")
+        self.L = L
+        self.errors_per_block = errors_per_block
+        self.n = N * L
+        self.r = SYN_BITS * L
+        self.rng = rng
+        # t=2 时每块有 1+15+105=121 种错误图样，取前 64 种编码 6 比特；t=1 时 16 种编码 4 比特
+        self._patterns = error_patterns(N, errors_per_block)
+        self._synd_table = syndrome_table(errors_per_block)
+        self.bits_per_block = len(self._patterns).bit_length() - 1
+        self._pattern_index = {e: v for v, e in enumerate(self._patterns[: 1 << self.bits_per_block])}
+        self.msg_bits = self.bits_per_block * L
+
+    def keygen(self) -> Tuple[NiederreiterPublicKey, NiederreiterPrivateKey]:
+        # H_pub = M * diag(H) * P。按列计算：私有第 (b, j) 列是基校验列移到第 b 段，再左乘 M。
+        # 直接采样 A = M^T 及其逆，列向量左乘 M 即行向量右乘 A，解密时右乘 A^-1 = (M^-1)^T
+        A, A_inv = random_invertible_pair(self.r)
+        base = base_syndrome_columns()
+        private_cols = PackedMatrix(
+            [base[j] << (SYN_BITS * b) for b in range(self.L) for j in range(N)], self.r
+        )
+        cols = packed_mul(private_cols, A).rows
+        P = random_permutation(self.n)
+        H_pub = unpack_matrix(packed_transpose(PackedMatrix([cols[p] for p in P], self.r)))
+        return (
+            NiederreiterPublicKey(
+                H_pub, self.n, self.r, self.L, self.errors_per_block, self.msg_bits, P, cols
+            ),
+            NiederreiterPrivateKey(unpack_matrix(A_inv), self._synd_table, self.L, self.errors_per_block, A_inv),
+        )
+
+    def encode_error(self, m_bits: BitVector) -> List[int]:
+        # 每块取 bits_per_block 位明文作为错误图样下标，返回私有位置上的错误位置列表
+        if len(m_bits) != self.msg_bits:
+            raise ValueError(f"明文长度必须 {self.msg_bits}")
+        positions = []
+        w = self.bits_per_block
+        for blk in range(self.L):
+            e = self._patterns[bits_to_int(m_bits[blk * w : (blk + 1) * w])]
+            while e:
+                low = e & -e
+                positions.append(blk * N + low.bit_length() - 1)
+                e ^= low
+        return positions
+
+    def encrypt(self, m_bits: BitVector, pub: NiederreiterPublicKey) -> BitVector:
+        cols = pub.columns()
+        s = 0
+        for p in self.encode_error(m_bits):
+            s ^= cols[p]
+        return int_to_bits(s, pub.r)
+
+    def decrypt(
+        self, s_bits: BitVector, pub: NiederreiterPublicKey, priv: NiederreiterPrivateKey
+    ) -> Tuple[BitVector, bool]:
+        if len(s_bits) != pub.r:
+            raise ValueError(f"密文长度必须 {pub.r}")
+        s = packed_vec_mul(bits_to_int(s_bits), priv.packed())
+        m: BitVector = []
         success = True
+        mask = (1 << SYN_BITS) - 1
         for blk in range(pub.L):
-            block = c_perm[blk * N : (blk + 1) * N]
-            msg, ok = decode_block(block, priv.synd_table)
-            decoded.extend(msg)
-            success = success and ok
-        m = mat_vec_mul(decoded, priv.S_inv)
+            syn = (s >> (SYN_BITS * blk)) & mask
+            e = priv.synd_table[syn]
+            v = self._pattern_index.get(e) if e >= 0 else None
+            if v is None:
+                success = False
+                v = 0
+            m.extend(int_to_bits(v, self.bits_per_block))
         return m, success
-
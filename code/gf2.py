@@ -1,99 +1,399 @@
+import itertools
+import os
 import random
-from typing import List, Sequence, Tuple
+from dataclasses import dataclass
+from operator import itemgetter
+from typing import Dict, List, Sequence, Tuple
 
 BitVector = List[int]
 Matrix = List[List[int]]
 
+_BIT_CHARS = "01"
+
+# Method of Four Russians 每次处理的行/列数，查表有 2^M4RI_K 项
+M4RI_K = 8
+# 行数或列数达到这个规模才用 M4RI，小矩阵建表不划算
+M4RI_MIN = 64
+
+# 装了 numpy 时大矩阵走 gf2_numpy 的 uint64 字运算；GF2_BACKEND=python 可强制使用纯 Python
+try:
+    from . import gf2_numpy as _numpy_backend
+except ImportError:
+    _numpy_backend = None
+
+BACKEND = "numpy" if _numpy_backend is not None and os.environ.get("GF2_BACKEND") != "python" else "python"
+
+
+def set_backend(name: str) -> None:
+    global BACKEND
+    if name not in ("numpy", "python"):
+        raise ValueError(f"未知后端 {name}")
+    if name == "numpy" and _numpy_backend is None:
+        raise ValueError("numpy 后端不可用，请先安装 numpy")
+    BACKEND = name
+
+
+def _use_numpy(size: int) -> bool:
+    return BACKEND == "numpy" and size >= M4RI_MIN
+
+
+@dataclass
+class PackedMatrix:
+    # 按行压缩的 GF(2) 矩阵：每行是一个整数，第 j 位对应第 j 列，行运算就是一次整数异或
+    rows: List[int]
+    ncols: int
+
+    @property
+    def nrows(self) -> int:
+        return len(self.rows)
+
 
 def bits_to_int(bits: Sequence[int]) -> int:
-    val = 0
-    for i, b in enumerate(bits):
-        if b & 1:
-            val |= 1 << i
-    return val
+    if not bits:
+        return 0
+    return int("".join([_BIT_CHARS[b & 1] for b in reversed(bits)]), 2)
 
 
 def int_to_bits(value: int, length: int) -> BitVector:
-    return [(value >> i) & 1 for i in range(length)]
+    if length <= 0:
+        return []
+    s = format(value & ((1 << length) - 1), "b").zfill(length)
+    return [1 if ch == "1" else 0 for ch in reversed(s)]
 
 
 def parity(x: int) -> int:
     return bin(x).count("1") & 1
 
 
-def mat_identity(n: int) -> Matrix:
-    return [int_to_bits(1 << i, n) for i in range(n)]
+def pack_matrix(mat: Matrix) -> PackedMatrix:
+    ncols = len(mat[0]) if mat else 0
+    return PackedMatrix([bits_to_int(row) for row in mat], ncols)
 
 
-def mat_inv(mat: Matrix) -> Matrix:
-    n = len(mat)
-    assert all(len(row) == n for row in mat), "矩阵必须为方阵"
-    A = [row[:] for row in mat]
-    I = mat_identity(n)
+def unpack_matrix(pm: PackedMatrix) -> Matrix:
+    return [int_to_bits(row, pm.ncols) for row in pm.rows]
+
+
+def packed_identity(n: int) -> PackedMatrix:
+    return PackedMatrix([1 << i for i in range(n)], n)
+
+
+def popcount(x: int) -> int:
+    return bin(x).count("1")
+
+
+def gray_code_table(rows: Sequence[int]) -> List[int]:
+    # 按 Gray 码顺序枚举 rows 的全部 2^len(rows) 种组合，相邻两项只差一行，每项只需一次异或
+    # table[idx] 是 idx 中为 1 的位所选中的行的异或
+    table = [0] * (1 << len(rows))
+    prev = 0
+    for i in range(1, len(table)):
+        g = i ^ (i >> 1)
+        changed = (g ^ prev).bit_length() - 1
+        table[g] = table[prev] ^ rows[changed]
+        prev = g
+    return table
+
+
+def packed_mul_m4ri(A: PackedMatrix, B: PackedMatrix) -> PackedMatrix:
+    # 把 B 按 M4RI_K 行一组切开，每组建一张组合表，A 的每行按对应的 8 位直接查表异或
+    assert A.ncols == B.nrows
+    acc = [0] * A.nrows
+    mask = (1 << M4RI_K) - 1
+    for base in range(0, B.nrows, M4RI_K):
+        table = gray_code_table(B.rows[base : base + M4RI_K])
+        acc = [a ^ table[(row >> base) & mask] for a, row in zip(acc, A.rows)]
+    return PackedMatrix(acc, B.ncols)
+
+
+def packed_inv_m4ri(pm: PackedMatrix) -> PackedMatrix:
+    # M4RI 形式的 Gauss-Jordan：每次处理 M4RI_K 列。
+    # 先在这几列上选出主元行并化成单位块，再用主元行的组合表一次消掉其余各行在这几列上的 1
+    n = pm.nrows
+    assert pm.ncols == n, "矩阵必须为方阵"
+    rows = [row | (1 << (n + i)) for i, row in enumerate(pm.rows)]
+    for base in range(0, n, M4RI_K):
+        width = min(M4RI_K, n - base)
+        for col in range(base, base + width):
+            bit = 1 << col
+            pivot = None
+            for r in range(col, n):
+                v = rows[r]
+                # 候选行先用本组已选出的主元消掉前面几列
+                for prev in range(base, col):
+                    if (v >> prev) & 1:
+                        v ^= rows[prev]
+                if v & bit:
+                    rows[r] = v
+                    pivot = r
+                    break
+            if pivot is None:
+                raise ValueError("矩阵不可逆")
+            if pivot != col:
+                rows[col], rows[pivot] = rows[pivot], rows[col]
+            p = rows[col]
+            for prev in range(base, col):
+                if rows[prev] & bit:
+                    rows[prev] ^= p
+        table = gray_code_table(rows[base : base + width])
+        mask = (1 << width) - 1
+        for r in range(n):
+            if base <= r < base + width:
+                continue
+            idx = (rows[r] >> base) & mask
+            if idx:
+                rows[r] ^= table[idx]
+    return PackedMatrix([row >> n for row in rows], n)
+
+
+def packed_inv(pm: PackedMatrix) -> PackedMatrix:
+    # 增广矩阵 [A | I] 的每行拼成一个整数，低 n 位是 A，高 n 位是 I
+    n = pm.nrows
+    assert pm.ncols == n, "矩阵必须为方阵"
+    if _use_numpy(n):
+        return PackedMatrix(_numpy_backend.inv(pm.rows, n), n)
+    if n >= M4RI_MIN:
+        return packed_inv_m4ri(pm)
+    rows = [row | (1 << (n + i)) for i, row in enumerate(pm.rows)]
     for col in range(n):
+        bit = 1 << col
         pivot = None
         for r in range(col, n):
-            if A[r][col]:
+            if rows[r] & bit:
                 pivot = r
                 break
         if pivot is None:
             raise ValueError("矩阵不可逆")
         if pivot != col:
-            A[col], A[pivot] = A[pivot], A[col]
-            I[col], I[pivot] = I[pivot], I[col]
+            rows[col], rows[pivot] = rows[pivot], rows[col]
+        p = rows[col]
         for r in range(n):
-            if r != col and A[r][col]:
-                for c in range(n):
-                    A[r][c] ^= A[col][c]
-                    I[r][c] ^= I[col][c]
-    return I
+            if r != col and rows[r] & bit:
+                rows[r] ^= p
+    return PackedMatrix([row >> n for row in rows], n)
+
+
+def packed_vec_mul(vec: int, B: PackedMatrix) -> int:
+    # 行向量乘矩阵：vec 中为 1 的位选中 B 的对应行，全部异或起来
+    # 不走 numpy 后端：单个向量只做一遍行异或，把矩阵转成 uint64 数组的开销已经超过整个运算；
+    # 多个向量请叠成矩阵用 packed_mul
+    acc = 0
+    rows = B.rows
+    i = 0
+    while vec:
+        if vec & 1:
+            acc ^= rows[i]
+        vec >>= 1
+        i += 1
+    return acc
+
+
+def packed_mul(A: PackedMatrix, B: PackedMatrix) -> PackedMatrix:
+    assert A.ncols == B.nrows
+    if _use_numpy(A.nrows) and B.nrows >= M4RI_K:
+        return PackedMatrix(_numpy_backend.mul(A.rows, A.ncols, B.rows, B.ncols), B.ncols)
+    if A.nrows >= M4RI_MIN and B.nrows >= M4RI_K:
+        return packed_mul_m4ri(A, B)
+    return PackedMatrix([packed_vec_mul(row, B) for row in A.rows], B.ncols)
+
+
+def block_interleave(width: int, blocks: int) -> List[int]:
+    # 分块顺序（第 b 块第 i 位在 width*b + i）到交错顺序（在 blocks*i + b）的下标映射
+    return [blocks * i + b for b in range(blocks) for i in range(width)]
+
+
+def packed_mul_block_diagonal(A: PackedMatrix, base: PackedMatrix, blocks: int) -> PackedMatrix:
+    # A * diag(base, ..., base)，A 的列和结果的列都按 block_interleave 的交错顺序排列。
+    # 交错后 A 每行的第 i 段（blocks 位）恰好是各块的第 i 个输入位，结果第 j 段就是 base 第 j 列选中的那几段的异或，
+    # 每行只需 base.nrows 次取段和 base.ncols 次拼接，所有块一起算，不需要构造稠密的块对角矩阵
+    kb, nb = base.nrows, base.ncols
+    assert A.ncols == kb * blocks
+    mask = (1 << blocks) - 1
+    col_sources = [[i for i in range(kb) if (base.rows[i] >> j) & 1] for j in range(nb)]
+    rows = []
+    for row in A.rows:
+        fields = [(row >> (blocks * i)) & mask for i in range(kb)]
+        out = 0
+        for sources in reversed(col_sources):
+            acc = 0
+            for i in sources:
+                acc ^= fields[i]
+            out = (out << blocks) | acc
+        rows.append(out)
+    return PackedMatrix(rows, nb * blocks)
+
+
+def packed_block_systematic(
+    base: PackedMatrix, blocks: int, perm: Sequence[int]
+) -> Tuple[PackedMatrix, List[int], PackedMatrix]:
+    # 求 diag(base, ..., base) 经列置换 perm（第 t 列取原来的第 perm[t] 列）后的系统形式 [I | R]。
+    # 行空间相同的矩阵化简行阶梯形唯一，所以 S·G·P 的系统形式与 S 无关，可以逐块直接求：
+    # 按列序贪心选出每块线性无关的 base.nrows 列作为信息集，块内用 base 在这些列上的子矩阵 B 的逆消元。
+    # 返回 R、公开列的新顺序（信息集在前，其余在后）、以及把各块按 base 译出的消息还原成明文的矩阵（各块为 B）
+    kb, nb = base.nrows, base.ncols
+    k, n = kb * blocks, nb * blocks
+    assert len(perm) == n
+    where = [0] * n
+    for t, p in enumerate(perm):
+        where[p] = t
+    base_cols = packed_transpose(base).rows
+    chosen: List[List[Tuple[int, int]]] = [[] for _ in range(blocks)]
+    basis: List[Dict[int, int]] = [{} for _ in range(blocks)]
+    for t, p in enumerate(perm):
+        b, j = divmod(p, nb)
+        if len(chosen[b]) == kb:
+            continue
+        v = base_cols[j]
+        while v:
+            top = v.bit_length() - 1
+            if top not in basis[b]:
+                basis[b][top] = v
+                chosen[b].append((t, j))
+                break
+            v ^= basis[b][top]
+    if any(len(c) != kb for c in chosen):
+        raise ValueError("基生成矩阵行不满秩")
+    info = sorted(t for c in chosen for t, _ in c)
+    row_of = {t: i for i, t in enumerate(info)}
+    rest = [t for t in range(n) if t not in row_of]
+    rest_col = {t: s for s, t in enumerate(rest)}
+    R = [0] * k
+    restore = [0] * k
+    for b in range(blocks):
+        cols = [j for _, j in chosen[b]]
+        B = PackedMatrix([sum(((row >> j) & 1) << c for c, j in enumerate(cols)) for row in base.rows], kb)
+        M = packed_mul(packed_inv(B), base)
+        for c, (t, _) in enumerate(chosen[b]):
+            # M 的第 c 行在本块信息列上只有第 c 位为 1，其余 1 都落在 R 的列里
+            r = 0
+            for j in range(nb):
+                tt = where[nb * b + j]
+                if (M.rows[c] >> j) & 1 and tt in rest_col:
+                    r |= 1 << rest_col[tt]
+            R[row_of[t]] = r
+        for r in range(kb):
+            for c, (t, _) in enumerate(chosen[b]):
+                if (B.rows[r] >> c) & 1:
+                    restore[kb * b + r] |= 1 << row_of[t]
+    return PackedMatrix(R, n - k), info + rest, PackedMatrix(restore, k)
+
+
+def packed_transpose(pm: PackedMatrix) -> PackedMatrix:
+    cols = [0] * pm.ncols
+    for i, row in enumerate(pm.rows):
+        bit = 1 << i
+        j = 0
+        while row:
+            if row & 1:
+                cols[j] |= bit
+            row >>= 1
+            j += 1
+    return PackedMatrix(cols, pm.nrows)
+
+
+def permute_bits(value: int, perm: Sequence[int]) -> int:
+    # 新的第 i 位取原来的第 perm[i] 位，与 apply_permutation 一致
+    # perm 可以只取一部分位（如信息集），字符串长度按最大下标补齐
+    if len(perm) == 0:
+        return 0
+    s = format(value, "b").zfill(max(perm) + 1)[::-1]
+    picked = itemgetter(*perm)(s)
+    return int("".join(picked)[::-1], 2)
+
+
+def packed_permute_columns(pm: PackedMatrix, perm: Sequence[int]) -> PackedMatrix:
+    n = len(perm)
+    if n == 0:
+        return PackedMatrix([0] * pm.nrows, 0)
+    if _use_numpy(pm.nrows):
+        return PackedMatrix(_numpy_backend.permute_columns(pm.rows, pm.ncols, perm), n)
+    getter = itemgetter(*perm)
+    rows = []
+    for row in pm.rows:
+        s = format(row, "b").zfill(pm.ncols)[::-1]
+        rows.append(int("".join(getter(s))[::-1], 2))
+    return PackedMatrix(rows, n)
+
+
+def random_packed_matrix(nrows: int, ncols: int, rng=random) -> PackedMatrix:
+    return PackedMatrix([rng.getrandbits(ncols) if ncols else 0 for _ in range(nrows)], ncols)
+
+
+def packed_unit_triangular_inv(pm: PackedMatrix, lower: bool = True) -> PackedMatrix:
+    # 对角线全 1 的三角矩阵求逆，不需要选主元：
+    # 下三角时 X[i] = e_i ^ sum(L[i][j] * X[j], j < i)，上三角时 j > i，逐行代入即可。
+    # 已算完的 X 行每 M4RI_K 行建一张组合表，每行按组查表，组内剩下的几位逐位处理
+    n = pm.nrows
+    assert pm.ncols == n, "矩阵必须为方阵"
+    X = [0] * n
+    tables: List[Tuple[int, int, List[int]]] = []
+    bases = range(0, n, M4RI_K) if lower else reversed(range(0, n, M4RI_K))
+    for base in bases:
+        width = min(M4RI_K, n - base)
+        order = range(base, base + width) if lower else range(base + width - 1, base - 1, -1)
+        done: List[int] = []
+        for i in order:
+            row = pm.rows[i]
+            acc = 1 << i
+            for tb, tmask, table in tables:
+                acc ^= table[(row >> tb) & tmask]
+            for j in done:
+                if (row >> j) & 1:
+                    acc ^= X[j]
+            X[i] = acc
+            done.append(i)
+        tables.append((base, (1 << width) - 1, gray_code_table(X[base : base + width])))
+    return PackedMatrix(X, n)
+
+
+def random_invertible_pair(size: int, rng=random) -> Tuple[PackedMatrix, PackedMatrix]:
+    # 直接构造 S = L * U * P（L、U 为单位下/上三角，P 为列置换），S 必然可逆，
+    # 逆矩阵 S^-1 = P^T * U^-1 * L^-1 随之得到，不用反复试探求逆
+    L = PackedMatrix([rng.getrandbits(i) | (1 << i) for i in range(size)], size)
+    U = PackedMatrix(
+        [(1 << i) | (rng.getrandbits(size - 1 - i) << (i + 1)) for i in range(size)], size
+    )
+    perm = list(range(size))
+    rng.shuffle(perm)
+    S = packed_permute_columns(packed_mul(L, U), perm)
+    LU_inv = packed_mul(packed_unit_triangular_inv(U, lower=False), packed_unit_triangular_inv(L))
+    # 右乘列置换相当于逆矩阵的行置换：S 的第 i 列取原来的第 perm[i] 列，则 S^-1 的第 i 行取原来的第 perm[i] 行
+    S_inv = PackedMatrix([LU_inv.rows[p] for p in perm], size)
+    return S, S_inv
+
+
+def random_invertible_packed(size: int, rng=random) -> PackedMatrix:
+    return random_invertible_pair(size, rng)[0]
+
+
+def mat_identity(n: int) -> Matrix:
+    return [int_to_bits(1 << i, n) for i in range(n)]
+
+
+def mat_inv(mat: Matrix) -> Matrix:
+    n = len(mat)
+    assert all(len(row) == n for row in mat), "矩阵必须为方阵"
+    return unpack_matrix(packed_inv(pack_matrix(mat)))
 
 
 def mat_mul(A: Matrix, B: Matrix) -> Matrix:
-    k, m = len(A), len(A[0])
-    assert len(B) == m
-    n = len(B[0])
-    res = [[0] * n for _ in range(k)]
-    # 预计算 B 列向量
-    cols = []
-    for j in range(n):
-        col_mask = 0
-        for i in range(m):
-            if B[i][j]:
-                col_mask |= 1 << i
-        cols.append(col_mask)
-    for r in range(k):
-        row_mask = bits_to_int(A[r])
-        for c in range(n):
-            res[r][c] = parity(row_mask & cols[c])
-    return res
+    assert len(B) == len(A[0])
+    return unpack_matrix(packed_mul(pack_matrix(A), pack_matrix(B)))
 
 
 def mat_vec_mul(vec: BitVector, mat: Matrix) -> BitVector:
     assert len(vec) == len(mat)
     n = len(mat[0])
-    res = [0] * n
-    cols = []
-    for j in range(n):
-        col_mask = 0
-        for i in range(len(vec)):
-            if mat[i][j]:
-                col_mask |= 1 << i
-        cols.append(col_mask)
-    row_mask = bits_to_int(vec)
-    for j in range(n):
-        res[j] = parity(row_mask & cols[j])
-    return res
+    # 只压缩被选中的行；与 packed_vec_mul 一样留在纯 Python 上
+    acc = 0
+    for i, b in enumerate(vec):
+        if b & 1:
+            acc ^= bits_to_int(mat[i])
+    return int_to_bits(acc, n)
 
 
 def random_invertible_matrix(size: int) -> Matrix:
-    while True:
-        mat = [[random.randint(0, 1) for _ in range(size)] for _ in range(size)]
-        try:
-            _ = mat_inv(mat)
-            return mat
-        except ValueError:
-            continue
+    return unpack_matrix(random_invertible_packed(size))
 
 
 def random_permutation(n: int) -> List[int]:
@@ -107,7 +407,7 @@ def apply_permutation(vec: BitVector, perm: Sequence[int]) -> BitVector:
 
 
 def apply_permutation_matrix(mat: Matrix, perm: Sequence[int]) -> Matrix:
-    return [[row[j] for j in perm] for row in mat]
+    return unpack_matrix(packed_permute_columns(pack_matrix(mat), perm))
 
 
 def pack_bits(bits: Sequence[int]) -> bytes:
@@ -134,3 +434,14 @@ def unpack_bits(data: bytes, length: int) -> BitVector:
 def weight(vec: Sequence[int]) -> int:
     return sum(1 for b in vec if b)
 
+
+def error_patterns(length: int, max_weight: int) -> List[int]:
+    # 重量不超过 max_weight 的全部错误图样（整数掩码），按重量从小到大、同重量按位置字典序排列
+    patterns = [0]
+    for w in range(1, max_weight + 1):
+        for positions in itertools.combinations(range(length), w):
+            mask = 0
+            for pos in positions:
+                mask |= 1 << pos
+            patterns.append(mask)
+    return patterns
@@ -0,0 +1,98 @@
+# GF(2) 矩阵运算的 numpy 后端（可选）。
+# 矩阵按行存成 uint64 数组，每个字放 64 列，第 j 列在第 j // 64 个字的第 j % 64 位，
+# 与 gf2.PackedMatrix 中整数行的位序一致。这里的函数只收发整数行列表，由 gf2 在矩阵足够大时调用；
+# 没有安装 numpy 时导入本模块会失败，gf2 退回纯 Python 实现。
+from typing import List, Sequence
+
+import numpy as np
+
+# 每次处理的行数，查表有 2^GROUP_BITS 项；取 8 可以直接用字节视图取下标
+GROUP_BITS = 8
+
+
+def words_for(ncols: int) -> int:
+    return max(1, (ncols + 63) // 64)
+
+
+def to_array(rows: Sequence[int], ncols: int) -> np.ndarray:
+    nbytes = words_for(ncols) * 8
+    buf = b"".join([row.to_bytes(nbytes, "little") for row in rows])
+    return np.frombuffer(buf, dtype="<u8").reshape(len(rows), nbytes // 8).copy()
+
+
+def from_array(arr: np.ndarray) -> List[int]:
+    data = np.ascontiguousarray(arr, dtype="<u8")
+    return [int.from_bytes(row.tobytes(), "little") for row in data]
+
+
+def combination_table(block: np.ndarray) -> np.ndarray:
+    # table[idx] 是 idx 中为 1 的位所选中的 block 行的异或，按位翻倍地构造
+    table = np.zeros((1 << len(block), block.shape[1]), dtype=np.uint64)
+    for b in range(len(block)):
+        half = 1 << b
+        np.bitwise_xor(table[:half], block[b], out=table[half : 2 * half])
+    return table
+
+
+def mul(a_rows: Sequence[int], a_ncols: int, b_rows: Sequence[int], b_ncols: int) -> List[int]:
+    # Four Russians：B 每 8 行建一张表，A 的对应字节就是表下标，整列一次查表异或
+    A = to_array(a_rows, a_ncols)
+    B = to_array(b_rows, b_ncols)
+    a_bytes = A.view(np.uint8)
+    C = np.zeros((len(a_rows), B.shape[1]), dtype=np.uint64)
+    for base in range(0, len(b_rows), GROUP_BITS):
+        table = combination_table(B[base : base + GROUP_BITS])
+        C ^= table[a_bytes[:, base // GROUP_BITS]]
+    return from_array(C)
+
+
+def inv(rows: Sequence[int], n: int) -> List[int]:
+    # 增广矩阵 [A | I]，A 占前 w 个字，I 占后 w 个字。与 gf2.packed_inv_m4ri 相同：
+    # 每 8 列先在字节上选出主元并化成单位块，再用主元行的组合表一次消掉其余各行
+    w = words_for(n)
+    M = np.zeros((n, 2 * w), dtype=np.uint64)
+    M[:, :w] = to_array(rows, n)
+    ident = np.arange(n)
+    M[ident, w + ident // 64] = np.left_shift(np.uint64(1), (ident % 64).astype(np.uint64))
+    as_bytes = M.view(np.uint8)
+    for base in range(0, n, GROUP_BITS):
+        width = min(GROUP_BITS, n - base)
+        byte = base // GROUP_BITS
+        # 候选行只在这一字节上消元，用来找主元，整行留到最后查表
+        cand = as_bytes[base:, byte].copy()
+        for j in range(width):
+            col = base + j
+            hits = np.flatnonzero((cand[j:] >> j) & 1)
+            if len(hits) == 0:
+                raise ValueError("矩阵不可逆")
+            pivot = col + int(hits[0])
+            if pivot != col:
+                M[[col, pivot]] = M[[pivot, col]]
+                cand[[j, pivot - base]] = cand[[pivot - base, j]]
+            rest = cand[j + 1 :]
+            rest[(rest >> j) & 1 == 1] ^= cand[j]
+            for prev in range(base, col):
+                if (as_bytes[col, byte] >> (prev - base)) & 1:
+                    M[col] ^= M[prev]
+            for prev in range(base, col):
+                if (as_bytes[prev, byte] >> j) & 1:
+                    M[prev] ^= M[col]
+        # A 中 base 之前的列已经是单位阵，只需处理从 base 所在字开始的部分
+        first = base // 64
+        table = combination_table(M[base : base + width, first:])
+        idx = as_bytes[:, byte].copy()
+        idx[base : base + width] = 0
+        M[:, first:] ^= table[idx]
+    return from_array(M[:, w:])
+
+
+def permute_columns(rows: Sequence[int], ncols: int, perm: Sequence[int]) -> List[int]:
+    # 展开成字节级的位矩阵，用花式下标一次取列，再按位压回
+    A = to_array(rows, ncols)
+    bits = np.unpackbits(A.view(np.uint8), axis=1, bitorder="little")
+    picked = bits[:, np.asarray(perm, dtype=np.intp)]
+    pad = words_for(len(perm)) * 64 - len(perm)
+    if pad:
+        picked = np.pad(picked, ((0, 0), (0, pad)))
+    packed = np.ascontiguousarray(np.packbits(picked, axis=1, bitorder="little"))
+    return from_array(packed.view("<u8"))
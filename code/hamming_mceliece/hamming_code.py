@@ -1,75 +1,145 @@
+import itertools
 import random
-from dataclasses import dataclass
-from typing import List, Tuple
+from dataclasses import dataclass, field
+from typing import List, Optional, Tuple
 
 from code.gf2 import (
     BitVector,
     Matrix,
+    PackedMatrix,
     apply_permutation,
-    apply_permutation_matrix,
-    mat_inv,
-    mat_mul,
-    mat_vec_mul,
+    bits_to_int,
+    block_interleave,
+    error_patterns,
+    gray_code_table,
+    int_to_bits,
     pack_bits,
-    random_invertible_matrix,
+    pack_matrix,
+    packed_block_systematic,
+    packed_mul,
+    packed_mul_block_diagonal,
+    packed_permute_columns,
+    packed_transpose,
+    packed_vec_mul,
+    random_invertible_pair,
     random_permutation,
+    unpack_matrix,
     weight,
 )
+from code.keyfile import BitRows, check_shape, decode_key, encode_key, map_file, save_bytes
 
 # (15,11) Hamming 单块参数
 PARITY_POS = [1, 2, 4, 8]
 DATA_POS = [i for i in range(1, 16) if i not in PARITY_POS]
 
 
+def _data_codeword(pos: int) -> int:
+    # 数据位 pos（1 起）为 1 时的码字：该位加上覆盖它的各校验位
+    return (1 << (pos - 1)) | sum(1 << (q - 1) for q in PARITY_POS if pos & q)
+
+
+# 消息 -> 码字的 2^11 项表，第 i 位消息对应 DATA_POS[i]，码字第 j 位是位置 j+1
+ENCODE_TABLE = gray_code_table([_data_codeword(pos) for pos in DATA_POS])
+
+
+def encode_block_int(msg: int) -> int:
+    return ENCODE_TABLE[msg]
+
+
+def encode_blocks_int(msg: int, L: int) -> int:
+    # 逐块取 11 位查表，码字按块拼回整数，不展开成列表
+    code = 0
+    for blk in range(L):
+        code |= ENCODE_TABLE[msg & 0x7FF] << (15 * blk)
+        msg >>= 11
+    return code
+
+
 def encode_block(msg11: BitVector) -> BitVector:
     if len(msg11) != 11:
         raise ValueError("消息块必须 11 比特")
-    code = [0] * 16  # 1-indexed
-    for bit, pos in zip(msg11, DATA_POS):
-        code[pos] = bit & 1
-    p1 = sum(code[i] for i in range(1, 16) if i & 1) & 1
-    p2 = sum(code[i] for i in range(1, 16) if i & 2) & 1
-    p4 = sum(code[i] for i in range(1, 16) if i & 4) & 1
-    p8 = sum(code[i] for i in range(1, 16) if i & 8) & 1
-    code[1], code[2], code[4], code[8] = p1, p2, p4, p8
-    return [code[i] for i in range(1, 16)]
+    return int_to_bits(ENCODE_TABLE[bits_to_int(msg11)], 15)
+
+
+def _byte_tables(f) -> Tuple[List[int], List[int]]:
+    # f 对 15 位整数是线性的，拆成低 8 位和高 7 位两张表，查两次表再异或即可
+    return [f(v) for v in range(256)], [f(v << 8) for v in range(128)]
+
+
+def _int_syndrome(v: int) -> int:
+    # 伴随式即所有为 1 的位置（1 起）的异或，单个错误时直接等于出错位置
+    syn = 0
+    for j in range(15):
+        if (v >> j) & 1:
+            syn ^= j + 1
+    return syn
+
+
+def _int_message(v: int) -> int:
+    return sum(((v >> (pos - 1)) & 1) << i for i, pos in enumerate(DATA_POS))
+
+
+SYN_LO, SYN_HI = _byte_tables(_int_syndrome)
+MSG_LO, MSG_HI = _byte_tables(_int_message)
+
+
+def _decode_entry(v: int) -> int:
+    syn = SYN_LO[v & 0xFF] ^ SYN_HI[v >> 8]
+    if syn:
+        v ^= 1 << (syn - 1)
+    return MSG_LO[v & 0xFF] | MSG_HI[v >> 8] | ((syn != 0) << 11)
+
+
+# 全部 2^15 种接收字的译码结果：低 11 位是消息，第 11 位表示做了纠正
+DECODE_TABLE = [_decode_entry(v) for v in range(1 << 15)]
+
+
+def decode_block_int(v: int) -> Tuple[int, bool]:
+    # v 的第 j 位是块内第 j 位，返回 11 位消息和是否做了纠正
+    e = DECODE_TABLE[v]
+    return e & 0x7FF, e > 0x7FF
+
+
+def decode_blocks_int(v: int, L: int) -> Tuple[int, bool]:
+    # 逐块从整数低位取 15 位查表，译出的 11 位消息按块拼回整数
+    d = 0
+    success = True
+    for blk in range(L):
+        e = DECODE_TABLE[v & 0x7FFF]
+        v >>= 15
+        d |= (e & 0x7FF) << (11 * blk)
+        success = success and e > 0x7FF
+    return d, success
 
 
 def syndrome_decode_block(code15: BitVector) -> Tuple[BitVector, bool]:
     if len(code15) != 15:
         raise ValueError("码长必须 15 比特")
-    code = [0] + code15[:]
-    s1 = sum(code[i] for i in range(1, 16) if i & 1) & 1
-    s2 = sum(code[i] for i in range(1, 16) if i & 2) & 1
-    s4 = sum(code[i] for i in range(1, 16) if i & 4) & 1
-    s8 = sum(code[i] for i in range(1, 16) if i & 8) & 1
-    syn = s1 | (s2 << 1) | (s4 << 2) | (s8 << 3)
-    corrected = False
-    if syn and 1 <= syn <= 15:
-        code[syn] ^= 1
-        corrected = True
-    msg = [code[pos] for pos in DATA_POS]
-    return msg, corrected
+    msg, corrected = decode_block_int(bits_to_int(code15))
+    return int_to_bits(msg, 11), corrected
+
+
+def base_generator_packed() -> PackedMatrix:
+    return PackedMatrix([ENCODE_TABLE[1 << i] for i in range(11)], 15)
 
 
 def base_generator() -> Matrix:
-    rows: Matrix = []
-    for i in range(11):
-        msg = [1 if j == i else 0 for j in range(11)]
-        rows.append(encode_block(msg))
-    return rows
+    return unpack_matrix(base_generator_packed())
+
+
+def base_syndrome_columns() -> List[int]:
+    # 单块校验矩阵按列给出：第 j 位（0 起）出错时伴随式为 j+1，与 _int_syndrome（SYN_LO/SYN_HI）一致
+    return [j + 1 for j in range(15)]
 
 
 def block_generator(L: int) -> Matrix:
-    base = base_generator()
-    k, n = 11 * L, 15 * L
-    G = [[0] * n for _ in range(k)]
-    for blk in range(L):
-        for r in range(11):
-            row_idx = blk * 11 + r
-            for c, v in enumerate(base[r]):
-                G[row_idx][blk * 15 + c] = v
-    return G
+    n = 15 * L
+    return [int_to_bits(encode_blocks_int(1 << i, L), n) for i in range(11 * L)]
+
+
+# 密钥文件中的类型字节，加载时据此拒绝别的方案或另一半密钥
+KEYFILE_PUBLIC = 1
+KEYFILE_PRIVATE = 2
 
 
 @dataclass
@@ -80,11 +150,39 @@ class PublicKey:
     L: int
     errors_per_block: int
     P: List[int]
+    # G_pub 的按行压缩形式，加密时直接按明文的 1 位异或对应行；keygen 会顺手填上
+    G_packed: Optional[PackedMatrix] = field(default=None, repr=False, compare=False)
+    # 系统形式公钥 [I_k | R]：G_pub 只存 k×(n-k) 的 R，密文前 k 位就是明文
+    systematic: bool = False
+
+    def packed(self) -> PackedMatrix:
+        if self.G_packed is None:
+            self.G_packed = pack_matrix(self.G_pub)
+        return self.G_packed
+
+    def serialize(self) -> bytes:
+        fields = [self.n, self.k, self.L, self.errors_per_block, int(self.systematic)]
+        return encode_key(KEYFILE_PUBLIC, fields, self.P, self.packed())
+
+    @classmethod
+    def deserialize(cls, data) -> "PublicKey":
+        # 矩阵行直接引用 data 的内存，G_pub 只在按列表访问时逐行展开
+        fields, P, G_packed = decode_key(data, KEYFILE_PUBLIC, 5)
+        n, k, L, errors_per_block, systematic = fields
+        if (n, k) != (15 * L, 11 * L):
+            raise ValueError("公钥尺寸与分块数不符")
+        check_shape(P, G_packed, n, k, n - k if systematic else n)
+        return cls(BitRows(G_packed), n, k, L, errors_per_block, P, G_packed, bool(systematic))
+
+    def save(self, path: str) -> None:
+        save_bytes(path, self.serialize())
+
+    @classmethod
+    def load(cls, path: str) -> "PublicKey":
+        return cls.deserialize(map_file(path))
 
     def serialize_size(self) -> int:
-        size_G = len(pack_bits([b for row in self.G_pub for b in row]))
-        size_P = len(self.P) * 2
-        return size_G + size_P
+        return len(self.serialize())
 
 
 @dataclass
@@ -93,15 +191,37 @@ class PrivateKey:
     P_inv: List[int]
     L: int
     errors_per_block: int
+    # S_inv 的按行压缩形式，批量解密时一次矩阵乘法还原全部明文；keygen 会顺手填上
+    S_packed: Optional[PackedMatrix] = field(default=None, repr=False, compare=False)
+
+    def packed(self) -> PackedMatrix:
+        if self.S_packed is None:
+            self.S_packed = pack_matrix(self.S_inv)
+        return self.S_packed
+
+    def serialize(self) -> bytes:
+        return encode_key(KEYFILE_PRIVATE, [self.L, self.errors_per_block], self.P_inv, self.packed())
+
+    @classmethod
+    def deserialize(cls, data) -> "PrivateKey":
+        fields, P_inv, S_packed = decode_key(data, KEYFILE_PRIVATE, 2)
+        L, errors_per_block = fields
+        check_shape(P_inv, S_packed, 15 * L, 11 * L, 11 * L)
+        return cls(BitRows(S_packed), P_inv, L, errors_per_block, S_packed)
+
+    def save(self, path: str) -> None:
+        save_bytes(path, self.serialize())
+
+    @classmethod
+    def load(cls, path: str) -> "PrivateKey":
+        return cls.deserialize(map_file(path))
 
     def serialize_size(self) -> int:
-        size_S = len(pack_bits([b for row in self.S_inv for b in row]))
-        size_P = len(self.P_inv) * 2
-        return size_S + size_P
+        return len(self.serialize())
 
 
 class HammingMcEliece:
-    def __init__(self, L: int, errors_per_block: int = 1, rng=random):
+    def __init__(self, L: int, errors_per_block: int = 1, rng=random, systematic: bool = False):
         if errors_per_block > 1:
             raise ValueError("Hamming(15,11) 仅能纠正 1 比特错误")
         self.L = L
@@ -109,19 +229,46 @@ class HammingMcEliece:
         self.n = 15 * L
         self.k = 11 * L
         self.rng = rng
-        self._G = block_generator(L)
+        self.systematic = systematic
+        # 只保存单块生成矩阵，S·G 按块对角结构在交错列序上计算
+        self._G_base = base_generator_packed()
+        self._msg_order = block_interleave(11, L)
+        self._code_order = block_interleave(15, L)
 
     def keygen(self) -> Tuple[PublicKey, PrivateKey]:
-        S = random_invertible_matrix(self.k)
-        S_inv = mat_inv(S)
+        if self.systematic:
+            return self._keygen_systematic()
+        # 在按行压缩的矩阵上完成求逆、乘法和列置换，最后再展开成公开的列表形式
+        # S 直接按交错列序采样（相当于对随机 S 再做一次列置换，分布不变），
+        # 换回分块顺序只需重排 S^-1 的行，并把交错顺序并入公钥的列置换
+        S, S_inv_packed = random_invertible_pair(self.k)
+        S_inv_packed = PackedMatrix([S_inv_packed.rows[i] for i in self._msg_order], self.k)
+        S_inv = unpack_matrix(S_inv_packed)
+        P = random_permutation(self.n)
+        P_inv = [0] * self.n
+        for i, p in enumerate(P):
+            P_inv[p] = i
+        SG = packed_mul_block_diagonal(S, self._G_base, self.L)
+        G_packed = packed_permute_columns(SG, [self._code_order[p] for p in P])
+        G_pub = unpack_matrix(G_packed)
+        return (
+            PublicKey(G_pub, self.n, self.k, self.L, self.errors_per_block, P, G_packed),
+            PrivateKey(S_inv, P_inv, self.L, self.errors_per_block, S_inv_packed),
+        )
+
+    def _keygen_systematic(self) -> Tuple[PublicKey, PrivateKey]:
+        # 系统形式与 S 无关，直接由 G·P 逐块求出；列置换并入信息集在前的新列序，
+        # 私钥的 S_inv 换成把各块译出的消息还原成明文的块对角矩阵
         P = random_permutation(self.n)
+        R, order, restore = packed_block_systematic(self._G_base, self.L, P)
+        P = [P[t] for t in order]
         P_inv = [0] * self.n
         for i, p in enumerate(P):
             P_inv[p] = i
-        G_pub = apply_permutation_matrix(mat_mul(S, self._G), P)
+        S_inv = unpack_matrix(restore)
         return (
-            PublicKey(G_pub, self.n, self.k, self.L, self.errors_per_block, P),
-            PrivateKey(S_inv, P_inv, self.L, self.errors_per_block),
+            PublicKey(unpack_matrix(R), self.n, self.k, self.L, self.errors_per_block, P, R, systematic=True),
+            PrivateKey(S_inv, P_inv, self.L, self.errors_per_block, restore),
         )
 
     def _sample_error_private(self) -> BitVector:
@@ -136,22 +283,190 @@ class HammingMcEliece:
     def encrypt(self, m_bits: BitVector, pub: PublicKey) -> BitVector:
         if len(m_bits) != pub.k:
             raise ValueError(f"明文长度必须 {pub.k}")
-        u = mat_vec_mul(m_bits, pub.G_pub)
+        m_int = bits_to_int(m_bits)
+        if pub.systematic:
+            u = m_int | (packed_vec_mul(m_int, pub.packed()) << pub.k)
+        else:
+            u = packed_vec_mul(m_int, pub.packed())
         e_private = self._sample_error_private()
         e_public = apply_permutation(e_private, pub.P)
-        return [(u[i] ^ e_public[i]) for i in range(pub.n)]
+        return int_to_bits(u ^ bits_to_int(e_public), pub.n)
+
+    def encrypt_batch(self, messages: List[BitVector], pub: PublicKey) -> List[BitVector]:
+        # N 条明文叠成 N×k 的压缩矩阵，一次矩阵乘法得到全部码字（N 达到 M4RI_MIN 时走 M4RI / numpy 内核）
+        for m_bits in messages:
+            if len(m_bits) != pub.k:
+                raise ValueError(f"明文长度必须 {pub.k}")
+        M = PackedMatrix([bits_to_int(m_bits) for m_bits in messages], pub.k)
+        if pub.systematic:
+            U = [m | (r << pub.k) for m, r in zip(M.rows, packed_mul(M, pub.packed()).rows)]
+        else:
+            U = packed_mul(M, pub.packed()).rows
+        E = self._sample_errors_public(len(messages), pub.P)
+        return [int_to_bits(u ^ e, pub.n) for u, e in zip(U, E)]
+
+    def _sample_errors_public(self, count: int, P: List[int]) -> List[int]:
+        # 一次抽出 count 条消息全部块的错误图样：每块在 errors_per_block 元组合中等概率取一个，
+        # 与逐块洗牌取前几位同分布；错误位置直接换到公开位置，按字符串一次拼出整数
+        P_inv = [0] * self.n
+        for i, p in enumerate(P):
+            P_inv[p] = i
+        combos = list(itertools.combinations(range(15), self.errors_per_block))
+        picks = self.rng.choices(combos, k=count * self.L)
+        n = self.n
+        blank = b"0" * n
+        out = []
+        for c in range(count):
+            chars = bytearray(blank)
+            for blk, combo in enumerate(picks[c * self.L : (c + 1) * self.L]):
+                for off in combo:
+                    chars[n - 1 - P_inv[blk * 15 + off]] = 49  # "1"
+            out.append(int(chars, 2))
+        return out
 
     def decrypt(self, c_bits: BitVector, pub: PublicKey, priv: PrivateKey) -> Tuple[BitVector, bool]:
         if len(c_bits) != pub.n:
             raise ValueError(f"密文长度必须 {pub.n}")
-        c_perm = apply_permutation(c_bits, priv.P_inv)
-        decoded: BitVector = []
+        c_perm = bits_to_int(apply_permutation(c_bits, priv.P_inv))
+        decoded, success = decode_blocks_int(c_perm, pub.L)
+        m = packed_vec_mul(decoded, priv.packed())
+        return int_to_bits(m, pub.k), success
+
+    def decrypt_batch(
+        self, ciphertexts: List[BitVector], pub: PublicKey, priv: PrivateKey
+    ) -> List[Tuple[BitVector, bool]]:
+        # 全部密文叠成 N×n 矩阵一次逆置换，逐块查整数表译码，译出的 N×k 矩阵再一次乘 S_inv
+        for c_bits in ciphertexts:
+            if len(c_bits) != pub.n:
+                raise ValueError(f"密文长度必须 {pub.n}")
+        C = packed_permute_columns(PackedMatrix([bits_to_int(c) for c in ciphertexts], pub.n), priv.P_inv)
+        decoded = []
+        flags = []
+        for row in C.rows:
+            d, success = decode_blocks_int(row, pub.L)
+            decoded.append(d)
+            flags.append(success)
+        M = packed_mul(PackedMatrix(decoded, pub.k), priv.packed())
+        return [(int_to_bits(m, pub.k), ok) for m, ok in zip(M.rows, flags)]
+
+
+# Niederreiter 变体：公钥是打乱的校验矩阵，密文是长度 n-k 的伴随式，明文编码在每块的错误图样里
+SYN_BITS = 4
+
+
+@dataclass
+class NiederreiterPublicKey:
+    H_pub: Matrix
+    n: int
+    r: int
+    L: int
+    errors_per_block: int
+    msg_bits: int
+    P: List[int]
+    # H_pub 的列按私有位置排好（第 p 项是公开第 P^-1[p] 列），加密时按错误位置直接取列异或
+    cols: Optional[List[int]] = field(default=None, repr=False, compare=False)
+
+    def columns(self) -> List[int]:
+        if self.cols is None:
+            public = packed_transpose(pack_matrix(self.H_pub)).rows
+            self.cols = [0] * self.n
+            for i, p in enumerate(self.P):
+                self.cols[p] = public[i]
+        return self.cols
+
+    def serialize_size(self) -> int:
+        size_H = len(pack_bits([b for row in self.H_pub for b in row]))
+        size_P = len(self.P) * 2
+        return size_H + size_P
+
+
+@dataclass
+class NiederreiterPrivateKey:
+    # 解密时把伴随式行向量右乘 M_inv 还原成各块的伴随式
+    M_inv: Matrix
+    L: int
+    errors_per_block: int
+    M_packed: Optional[PackedMatrix] = field(default=None, repr=False, compare=False)
+
+    def packed(self) -> PackedMatrix:
+        if self.M_packed is None:
+            self.M_packed = pack_matrix(self.M_inv)
+        return self.M_packed
+
+    def serialize_size(self) -> int:
+        return len(pack_bits([b for row in self.M_inv for b in row]))
+
+
+class HammingNiederreiter:
+    def __init__(self, L: int, errors_per_block: int = 1, rng=random):
+        if errors_per_block != 1:
+            raise ValueError("Hamming(15,11) 的 Niederreiter 变体每块恰好编码 0 或 1 个错误")
+        self.L = L
+        self.errors_per_block = errors_per_block
+        self.n = 15 * L
+        self.r = SYN_BITS * L
+        self.rng = rng
+        # 每块 16 种错误图样（无错或 15 个位置之一），恰好编码 4 比特
+        self._patterns = error_patterns(15, errors_per_block)
+        self.bits_per_block = len(self._patterns).bit_length() - 1
+        self._pattern_index = {e: v for v, e in enumerate(self._patterns[: 1 << self.bits_per_block])}
+        self.msg_bits = self.bits_per_block * L
+
+    def keygen(self) -> Tuple[NiederreiterPublicKey, NiederreiterPrivateKey]:
+        # H_pub = M * diag(H) * P。按列计算：私有第 (b, j) 列是基校验列移到第 b 段，再左乘 M。
+        # 直接采样 A = M^T 及其逆，列向量左乘 M 即行向量右乘 A，解密时右乘 A^-1 = (M^-1)^T
+        A, A_inv = random_invertible_pair(self.r)
+        base = base_syndrome_columns()
+        private_cols = PackedMatrix(
+            [base[j] << (SYN_BITS * b) for b in range(self.L) for j in range(15)], self.r
+        )
+        cols = packed_mul(private_cols, A).rows
+        P = random_permutation(self.n)
+        H_pub = unpack_matrix(packed_transpose(PackedMatrix([cols[p] for p in P], self.r)))
+        return (
+            NiederreiterPublicKey(
+                H_pub, self.n, self.r, self.L, self.errors_per_block, self.msg_bits, P, cols
+            ),
+            NiederreiterPrivateKey(unpack_matrix(A_inv), self.L, self.errors_per_block, A_inv),
+        )
+
+    def encode_error(self, m_bits: BitVector) -> List[int]:
+        # 每块取 bits_per_block 位明文作为错误图样下标，返回私有位置上的错误位置列表
+        if len(m_bits) != self.msg_bits:
+            raise ValueError(f"明文长度必须 {self.msg_bits}")
+        positions = []
+        w = self.bits_per_block
+        for blk in range(self.L):
+            e = self._patterns[bits_to_int(m_bits[blk * w : (blk + 1) * w])]
+            while e:
+                low = e & -e
+                positions.append(blk * 15 + low.bit_length() - 1)
+                e ^= low
+        return positions
+
+    def encrypt(self, m_bits: BitVector, pub: NiederreiterPublicKey) -> BitVector:
+        cols = pub.columns()
+        s = 0
+        for p in self.encode_error(m_bits):
+            s ^= cols[p]
+        return int_to_bits(s, pub.r)
+
+    def decrypt(
+        self, s_bits: BitVector, pub: NiederreiterPublicKey, priv: NiederreiterPrivateKey
+    ) -> Tuple[BitVector, bool]:
+        if len(s_bits) != pub.r:
+            raise ValueError(f"密文长度必须 {pub.r}")
+        s = packed_vec_mul(bits_to_int(s_bits), priv.packed())
+        m: BitVector = []
         success = True
+        mask = (1 << SYN_BITS) - 1
         for blk in range(pub.L):
-            block = c_perm[blk * 15 : (blk + 1) * 15]
-            msg, ok = syndrome_decode_block(block)
-            decoded.extend(msg)
-            success = success and ok
-        m = mat_vec_mul(decoded, priv.S_inv)
+            # 与 _int_syndrome（SYN_LO/SYN_HI）相同：非零伴随式就是出错位置（1 起）
+            syn = (s >> (SYN_BITS * blk)) & mask
+            e = 1 << (syn - 1) if syn else 0
+            v = self._pattern_index.get(e)
+            if v is None:
+                success = False
+                v = 0
+            m.extend(int_to_bits(v, self.bits_per_block))
         return m, success
-
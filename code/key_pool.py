@@ -0,0 +1,91 @@
+import random
+import threading
+from collections import deque
+from concurrent.futures import Future, ProcessPoolExecutor
+from concurrent.futures import TimeoutError as FutureTimeout
+from typing import Any, Deque, Dict, Optional, Tuple
+
+
+def _reseed() -> None:
+    # fork 出的子进程会继承父进程 random 的状态，不重新播种的话各进程会生成相同的密钥
+    random.seed()
+
+
+def _keygen_job(scheme_cls, L: int, kwargs: Dict[str, Any]) -> Tuple[Any, Any]:
+    return scheme_cls(L, **kwargs).keygen()
+
+
+class KeyPool:
+    # 在进程池里预先生成同一套参数 (scheme, L, errors_per_block) 的密钥对。
+    # get() 优先交出已经生成好的一对，同时补交一个新任务，让池里始终有 size 个在生成或已就绪
+    def __init__(
+        self,
+        scheme_cls,
+        L: int,
+        errors_per_block: Optional[int] = None,
+        size: int = 4,
+        workers: Optional[int] = None,
+        **scheme_kwargs,
+    ):
+        if size < 1:
+            raise ValueError("密钥池容量至少为 1")
+        self.scheme_cls = scheme_cls
+        self.L = L
+        self.size = size
+        self._kwargs = dict(scheme_kwargs)
+        if errors_per_block is not None:
+            self._kwargs["errors_per_block"] = errors_per_block
+        # 先在本进程构造一次，参数不合法时立刻报错而不是等到子进程里
+        scheme_cls(L, **self._kwargs)
+        self._executor = ProcessPoolExecutor(max_workers=workers, initializer=_reseed)
+        self._pending: Deque[Future] = deque()
+        self._lock = threading.Lock()
+        self._closed = False
+        with self._lock:
+            self._refill()
+
+    def _refill(self) -> None:
+        while len(self._pending) < self.size:
+            self._pending.append(self._executor.submit(_keygen_job, self.scheme_cls, self.L, self._kwargs))
+
+    def ready(self) -> int:
+        with self._lock:
+            return sum(1 for f in self._pending if f.done())
+
+    def get(self, timeout: Optional[float] = None) -> Tuple[Any, Any]:
+        # 有已完成的任务就直接取走（不必按提交顺序），否则等最早提交的那个。
+        # 等待超时的任务放回队首，不补交新任务，免得池外多出一个与补充任务抢进程的 keygen
+        with self._lock:
+            if not self._pending:
+                raise RuntimeError("密钥池已关闭")
+            chosen = next((f for f in self._pending if f.done()), self._pending[0])
+            self._pending.remove(chosen)
+        timed_out = False
+        try:
+            return chosen.result(timeout)
+        except FutureTimeout:
+            timed_out = True
+            with self._lock:
+                if not self._closed:
+                    self._pending.appendleft(chosen)
+            raise
+        finally:
+            # 取走（或任务本身出错）后补交一个；超时的那个还在队里，不补
+            if not timed_out:
+                with self._lock:
+                    if not self._closed:
+                        self._refill()
+
+    def close(self) -> None:
+        with self._lock:
+            self._closed = True
+            for f in self._pending:
+                f.cancel()
+            self._pending.clear()
+        self._executor.shutdown(wait=True, cancel_futures=True)
+
+    def __enter__(self) -> "KeyPool":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
@@ -0,0 +1,146 @@
+import mmap
+from collections.abc import Sequence
+from typing import List, Optional, Tuple, Union
+
+from code.gf2 import PackedMatrix, int_to_bits
+
+# 密钥文件格式（所有整数为 LEB128 无符号 varint）：
+#   魔数 b"MEK" | 版本 | 类型 | 字段个数 | 各字段 | 置换长度 | 置换各项 | 行数 | 列数 | 矩阵
+# 矩阵放在最后，逐行按 ceil(列数/8) 字节小端存放，第 j 位对应第 j 列，与 PackedMatrix 一致，
+# 加载时直接在映射的内存上按行取整数，不整体拷贝
+MAGIC = b"MEK"
+VERSION = 1
+
+Buffer = Union[bytes, bytearray, memoryview]
+
+
+def write_varint(out: bytearray, value: int) -> None:
+    if value < 0:
+        raise ValueError("varint 只能编码非负整数")
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def read_varint(buf: Buffer, pos: int) -> Tuple[int, int]:
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(buf):
+            raise ValueError("密钥文件被截断")
+        byte = buf[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+class MappedRows(Sequence):
+    # 矩阵行的只读视图：底层是文件映射（或任意缓冲区）上的一段内存，取第 i 行时才转成整数。
+    # 转好的行留在缓存里，加密解密反复取同一行时不再重复转换
+    def __init__(self, buf: memoryview, row_bytes: int, nrows: int):
+        self._buf = buf
+        self._row_bytes = row_bytes
+        self._nrows = nrows
+        self._cache: List[Optional[int]] = [None] * nrows
+
+    def __len__(self) -> int:
+        return self._nrows
+
+    def __getitem__(self, index):
+        if isinstance(index, slice):
+            return [self[i] for i in range(*index.indices(self._nrows))]
+        if index < 0:
+            index += self._nrows
+        if not 0 <= index < self._nrows:
+            raise IndexError(index)
+        row = self._cache[index]
+        if row is None:
+            start = index * self._row_bytes
+            row = self._cache[index] = int.from_bytes(self._buf[start : start + self._row_bytes], "little")
+        return row
+
+
+class BitRows(Sequence):
+    # 按需把压缩矩阵的行展开成比特列表，给仍按列表形式访问 G_pub / S_inv 的代码用，加载时不必整体展开
+    def __init__(self, pm: PackedMatrix):
+        self._pm = pm
+
+    def __len__(self) -> int:
+        return self._pm.nrows
+
+    def __getitem__(self, index):
+        if isinstance(index, slice):
+            return [self[i] for i in range(*index.indices(len(self)))]
+        return int_to_bits(self._pm.rows[index], self._pm.ncols)
+
+
+def encode_key(kind: int, fields: List[int], perm: List[int], mat: PackedMatrix) -> bytes:
+    out = bytearray(MAGIC)
+    out.append(VERSION)
+    out.append(kind)
+    write_varint(out, len(fields))
+    for v in fields:
+        write_varint(out, v)
+    write_varint(out, len(perm))
+    for v in perm:
+        write_varint(out, v)
+    write_varint(out, mat.nrows)
+    write_varint(out, mat.ncols)
+    row_bytes = (mat.ncols + 7) // 8
+    out += b"".join([row.to_bytes(row_bytes, "little") for row in mat.rows])
+    return bytes(out)
+
+
+def decode_key(data: Buffer, kind: int, nfields: int) -> Tuple[List[int], List[int], PackedMatrix]:
+    buf = memoryview(data)
+    if len(buf) < len(MAGIC) + 2:
+        raise ValueError("密钥文件被截断")
+    if bytes(buf[: len(MAGIC)]) != MAGIC:
+        raise ValueError("不是密钥文件")
+    if buf[len(MAGIC)] != VERSION:
+        raise ValueError(f"不支持的密钥文件版本 {buf[len(MAGIC)]}")
+    if buf[len(MAGIC) + 1] != kind:
+        raise ValueError("密钥类型不匹配")
+    pos = len(MAGIC) + 2
+    count, pos = read_varint(buf, pos)
+    if count != nfields:
+        raise ValueError(f"密钥字段个数应为 {nfields}，文件中为 {count}")
+    fields = []
+    for _ in range(count):
+        v, pos = read_varint(buf, pos)
+        fields.append(v)
+    count, pos = read_varint(buf, pos)
+    perm = []
+    for _ in range(count):
+        v, pos = read_varint(buf, pos)
+        perm.append(v)
+    nrows, pos = read_varint(buf, pos)
+    ncols, pos = read_varint(buf, pos)
+    row_bytes = (ncols + 7) // 8
+    if len(buf) - pos != nrows * row_bytes:
+        raise ValueError("密钥文件长度与矩阵尺寸不符")
+    return fields, perm, PackedMatrix(MappedRows(buf[pos:], row_bytes, nrows), ncols)
+
+
+def check_shape(perm: List[int], mat: PackedMatrix, n: int, nrows: int, ncols: int) -> None:
+    # 头部字段决定了置换长度和矩阵尺寸，三者对不上说明文件损坏或被拼接过
+    if len(perm) != n:
+        raise ValueError(f"置换长度应为 {n}，文件中为 {len(perm)}")
+    if sorted(perm) != list(range(n)):
+        raise ValueError("置换项有重复或越界")
+    if (mat.nrows, mat.ncols) != (nrows, ncols):
+        raise ValueError(f"矩阵尺寸应为 {nrows}×{ncols}，文件中为 {mat.nrows}×{mat.ncols}")
+
+
+def map_file(path: str) -> memoryview:
+    # 只读映射整个文件；返回的 memoryview 引用着映射对象，密钥对象存活期间映射一直有效
+    with open(path, "rb") as f:
+        return memoryview(mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ))
+
+
+def save_bytes(path: str, data: bytes) -> None:
+    with open(path, "wb") as f:
+        f.write(data)
@@ -1,21 +1,82 @@
+//syscall、clock_gettime等在-std=c11下需要显式打开GNU扩展才有声明 
+#define _GNU_SOURCE 
 #include <stdio.h> 
  #include <stdlib.h> 
  #include <time.h> 
  #include <stdbool.h> 
+ #include <string.h> 
+ #include <pthread.h> 
+ #include <stdatomic.h> 
+ #include <stdint.h> 
+ #include <limits.h> 
+ #include <math.h> 
+ #include <unistd.h> 
+ #ifdef __linux__ 
+ #include <linux/perf_event.h> 
+ #include <sys/ioctl.h> 
+ #include <sys/syscall.h> 
+ #endif 
  
  #define M_S 1024//内存的总字节数 
  #define Total_Procs 10//总进程数 
  #define Min_R 100//最少的请求内存 
  #define Max_R 200//最多的请求内存 
  
+ #define Skip_Max_Level 24//块链表跳表索引的最高层数 
+ #define MT_Max_Threads 64//多线程模式最多的线程数 
+ #define MT_Arena_Size 65536//每个线程arena的字节数 
+ #define MT_Shared_Size 65536//共享后备arena的字节数 
+ #define MT_Live_Slots 352//每个线程同时持有的最多分配块数 
+ #define Slab_Classes 8//小对象尺寸类个数 
+ #define Slab_Objs_Per_Class 65536//每个尺寸类预先切好的对象数 
+ #define Slab_Min_R 8//小对象最少的请求内存 
+ #define Slab_Max_R 256//小对象最多的请求内存 
+ #define Slab_Live_Slots 256//每个线程同时持有的最多小对象数 
+ #define Mag_Size 64//每个线程每个尺寸类的magazine容量 
+ #define Quick_Bin_Width 16//快速链表按块大小分箱的粒度 
+ #define Quick_Max_Size 256//不超过该大小的块释放时才进入快速链表 
+ #define Quick_Bins (Quick_Max_Size / Quick_Bin_Width + 1) 
+ #define Churn_Min_R 16//合并策略实验的最少请求内存 
+ #define Churn_Max_R 512//合并策略实验的最多请求内存 
+ #define Churn_Live_Slots 192//合并策略实验同时持有的最多分配块数 
+ #define Churn_Arena_Per_Slot 352//实验arena大小 = 同时持有块数 × 该值，约为平均请求的4/3倍 
+ #define Churn_Sample_Every 64//每隔多少次操作采样一次碎片率 
+ #define Bench_Max_Live 4096//基准测试同时存活对象数的上限 
+ #define Bench_Heaps 5//基准测试的堆大小档数，1KB起每档乘64，直到16GB 
+ #define Lifetime_Max_Sites 256//寿命分区策略最多区分的调用点数，更大的调用点编号取模 
+ #define Lifetime_Long_Factor 2//调用点平均寿命超过全体平均寿命的该倍数即判为长寿命 
+ #define Paging_Page_Size 256//联合模拟默认的页大小 
+ #define Paging_Touches_Per_Op 4//每条轨迹操作之后访问存活对象的次数 
+ #define Paging_Hot_Objects 32//最近分配的对象构成热点集合 
+ #define Paging_Hot_Pct 80//访问落在热点集合上的百分比 
+ #define Region_Arena_Bits 42//大区域管理器实验的地址空间，2^42字节 = 4TB 
+ #define Region_Min_Bits 20//大区域请求最小1MB 
+ #define Region_Max_Bits 36//大区域请求最大64GB 
+ #define Region_Live 192//大区域实验同时持有的最多区域数 
+ #define MC_Batch 64//蒙特卡洛实验中每批种子数，每批计一次吞吐 
+ #define MT_Exchange_Per_Thread 8//每个线程对应的交换槽位数，线程间通过交换槽传递分配块，制造跨线程释放 
+ 
+ typedef long long Addr;//地址和字节数，用64位以支持GB级的堆 
+ 
+ //跳表中块在某一层的前向指针 
+ typedef struct SkipLink { 
+     struct Block* next;//本层的下一个块 
+     Addr span_max;//从本块到本层下一个块之前（不含）所有空闲块的最大大小 
+ } SkipLink; 
+ 
  typedef struct Block { 
      int id;// 块号 
-     int startAddr; // 起始地址 
-     int endAddr;// 结束地址 
+     Addr startAddr; // 起始地址 
+     Addr endAddr;// 结束地址 
      bool free; //表示一个块是否空闲 
      int pid;//进程号, -1表示没有分配 
      struct Block* prev;//指向上一个块 
      struct Block* next;//指向下一个块 
+     struct Arena* owner;//块所属的arena 
+     struct Block* remote_next;//跨线程释放队列中的下一个块 
+     struct Block* quick_next;//快速链表中的下一个块 
+     int level;//跳表层数，第0层与prev/next双向链表一致 
+     SkipLink link[];//各层的前向指针，随块一起分配 
  } Block; 
  
  typedef struct PCB { 
@@ -26,75 +87,259 @@
      struct PCB* next; 
  } PCB; 
  
- static int Block_ID = 0;//分配全局ID 
- static Block* head = NULL; //指向内存块链表的头 
+ //arena：一段独立管理的地址区间，拥有自己的块链表和块ID计数器 
+ //单线程演示只用main_arena；多线程模式下每个线程一个arena，另有一个加锁的共享后备arena 
+ typedef struct Arena { 
+     int id;//arena编号，-1表示共享后备arena 
+     Addr baseAddr;//区间起始地址 
+     Addr size;//区间字节数 
+     int Block_ID;//分配ID 
+     Block* head;//指向内存块链表的头 
+     //按起始地址有序的块链表同时用跳表索引，插入、删除、按地址定位都是O(log n)； 
+     //每层记录区间内最大空闲块，首次适应可以整段跳过放不下的区间 
+     Block* skip_head;//跳表头结点，不是真实的块 
+     int skip_level;//当前最高层数 
+     unsigned int skip_rng;//生成随机层数用，不影响rand()的序列 
+     unsigned int rng;//线程私有的随机数状态，0表示使用rand() 
+     pthread_mutex_t lock;//仅共享arena使用 
+     bool shared; 
+     _Atomic(Block*) remote_free;//其他线程释放的块，无锁MPSC队列（多生产者压栈，属主线程一次性取走） 
+     //竞争统计 
+     long lock_acquires;//加锁次数 
+     long lock_contended;//trylock失败后阻塞等待的次数 
+     atomic_long remote_pushes;//收到的跨线程释放数 
+     atomic_long remote_cas_retries;//跨线程释放时CAS重试次数 
+     long remote_drains;//属主取走队列的批次数 
+     //延迟合并：quick_threshold为0时每次回收立即合并；否则小块先挂到快速链表， 
+     //分配失败或快速链表中的块数达到阈值时再批量合并（类似dlmalloc的fastbins） 
+     int quick_threshold; 
+     int quick_count;//快速链表中的块数 
+     Block* quick[Quick_Bins];//按块大小分箱的快速链表，链表中的块仍标记为已用，不参与合并 
+     long quick_hits;//直接从快速链表复用的次数 
+     long consolidations;//批量合并的次数 
+     long long meta_bytes;//块结构体（含跳表指针）当前占用的字节数 
+     long long meta_peak;//meta_bytes的峰值 
+     int fit;//放置策略，见FitPolicy 
+     Addr last_addr;//循环首次适应下一次查找的起始地址 
+     int placement;//块内放置方式，见Placement 
+     bool place_high;//当前这次分配贴着空闲块高端放置（寿命分区的长寿命对象） 
+     long search_steps;//查找空闲块时访问的结点数，衡量查找长度 
+ } Arena; 
+ 
+ //FIT_LIFETIME：按预测寿命分区，短寿命对象从低地址首次适应、长寿命对象从高地址反向适应，两区边界随需要浮动； 
+ //没有寿命提示时等同首次适应 
+ typedef enum { FIT_FIRST, FIT_NEXT, FIT_BEST, FIT_WORST, FIT_LIFETIME } FitPolicy; 
+ static const char* fit_name[] = { "首次适应(FF)", "循环首次适应(NF)", "最佳适应(BF)", "最坏适应(WF)", "寿命分区(LS)" }; 
+ 
+ //在选中的空闲块内怎样放置：演示沿用随机起始地址；贴边放置则从块的低端切（长寿命对象从高端切） 
+ typedef enum { PLACE_RANDOM, PLACE_EDGE } Placement; 
+ static const char* place_name[] = { "随机起始地址", "贴边放置" }; 
+ 
+ static Arena main_arena = { .id = 0, .baseAddr = 0, .size = M_S }; 
+ 
+ //xorshift32，多线程下代替rand() 
+ unsigned int xorshift32(unsigned int* s) { 
+     unsigned int x = *s; 
+     x ^= x << 13; 
+     x ^= x >> 17; 
+     x ^= x << 5; 
+     *s = x; 
+     return x; 
+ } 
+ 
+ int arena_rand(Arena* a) { 
+     if (a->rng == 0) return rand(); 
+     return (int)(xorshift32(&a->rng) & 0x7fffffff); 
+ } 
+ 
+ //[0, n)内的随机数，n不超过2^31时与arena_rand(a) % n相同，更大的区间拼两次随机数 
+ Addr arena_rand_below(Arena* a, Addr n) { 
+     if (n <= 0x7fffffff) return arena_rand(a) % n; 
+     Addr hi = arena_rand(a) & 0x7fffffff; 
+     Addr lo = arena_rand(a) & 0x7fffffff; 
+     return ((hi << 31) | lo) % n; 
+ } 
+ 
+ //随机层数，每升一层的概率减半 
+ int skip_random_level(Arena* a) { 
+     if (a->skip_rng == 0) a->skip_rng = 0x2545f491u; 
+     int lvl = 1; 
+     while (lvl < Skip_Max_Level && (xorshift32(&a->skip_rng) & 1)) lvl++; 
+     return lvl; 
+ } 
+ 
+ Block* skip_header(Arena* a) { 
+     if (!a->skip_head) { 
+         a->skip_head = (Block*)calloc(1, sizeof(Block) + Skip_Max_Level * sizeof(SkipLink)); 
+         if (!a->skip_head) { perror("calloc"); exit(1); } 
+         a->skip_head->level = Skip_Max_Level; 
+         a->skip_head->startAddr = LLONG_MIN; 
+         a->skip_level = 1; 
+         a->meta_bytes += sizeof(Block) + Skip_Max_Level * sizeof(SkipLink); 
+         if (a->meta_bytes > a->meta_peak) a->meta_peak = a->meta_bytes; 
+     } 
+     return a->skip_head; 
+ } 
+ 
+ //找出每一层中起始地址小于addr的最后一个块，存入upd 
+ void skip_path(Arena* a, Addr addr, Block** upd) { 
+     Block* x = skip_header(a); 
+     for (int i = a->skip_level - 1; i >= 0; --i) { 
+         while (x->link[i].next && x->link[i].next->startAddr < addr) x = x->link[i].next; 
+         upd[i] = x; 
+     } 
+ } 
+ 
+ //重新计算块p在第i层的span_max，要求第i-1层已经是最新的 
+ void skip_recompute(Block* p, int i) { 
+     if (i == 0) { 
+         p->link[0].span_max = p->free ? p->endAddr - p->startAddr + 1 : 0; 
+         return; 
+     } 
+     Addr m = 0; 
+     Block* end = p->link[i].next; 
+     for (Block* q = p; q != end; q = q->link[i - 1].next) { 
+         if (q->link[i - 1].span_max > m) m = q->link[i - 1].span_max; 
+     } 
+     p->link[i].span_max = m; 
+ } 
+ 
+ //块x的空闲状态或大小改变后，自底向上修正包含它的各层区间 
+ void skip_fix(Arena* a, Block* x) { 
+     Block* upd[Skip_Max_Level]; 
+     skip_path(a, x->startAddr, upd); 
+     for (int i = 0; i < a->skip_level; ++i) { 
+         skip_recompute(upd[i]->link[i].next == x ? x : upd[i], i); 
+     } 
+ } 
+ 
+ //批量修改空闲状态之后整体重算，O(n) 
+ void skip_rebuild(Arena* a) { 
+     Block* h = skip_header(a); 
+     for (int i = 0; i < a->skip_level; ++i) { 
+         for (Block* p = h; p; p = p->link[i].next) skip_recompute(p, i); 
+     } 
+ } 
  
  //从双向链表数组指定索引的链表中删除节点 
- void remove_node(Block* node) { 
+ void remove_node(Arena* a, Block* node) { 
      if (!node) return; 
+     Block* upd[Skip_Max_Level]; 
+     skip_path(a, node->startAddr, upd); 
+     for (int i = 0; i < node->level; ++i) { 
+         upd[i]->link[i].next = node->link[i].next; 
+         node->link[i].next = NULL; 
+     } 
+     while (a->skip_level > 1 && !a->skip_head->link[a->skip_level - 1].next) a->skip_level--; 
+     for (int i = 0; i < a->skip_level; ++i) skip_recompute(upd[i], i); 
      if (node->prev) node->prev->next = node->next; 
-     else head = node->next; // node 是头节点 
+     else a->head = node->next; // node 是头节点 
      if (node->next) node->next->prev = node->prev; 
      node->prev = node->next = NULL; 
  } 
  
  //创建新的内存块 
- Block* new_block(int startAddr, int endAddr, bool free, int pid) { 
-     Block* b = (Block*)malloc(sizeof(Block)); 
+ Block* new_block(Arena* a, Addr startAddr, Addr endAddr, bool free, int pid) { 
+     int level = skip_random_level(a); 
+     Block* b = (Block*)malloc(sizeof(Block) + level * sizeof(SkipLink)); 
      if (!b) { perror("malloc"); exit(1); } 
-     b->id = ++Block_ID; 
+     b->id = ++a->Block_ID; 
      b->startAddr = startAddr; 
      b->endAddr = endAddr; 
      b->free = free; 
      b->pid = pid; 
      b->prev = b->next = NULL; 
+     b->owner = a; 
+     b->remote_next = NULL; 
+     b->quick_next = NULL; 
+     b->level = level; 
+     memset(b->link, 0, level * sizeof(SkipLink)); 
+     a->meta_bytes += sizeof(Block) + level * sizeof(SkipLink); 
+     if (a->meta_bytes > a->meta_peak) a->meta_peak = a->meta_bytes; 
      return b; 
  } 
  
+ //释放块结构体，并从元数据统计中扣除 
+ void free_block(Arena* a, Block* b) { 
+     a->meta_bytes -= sizeof(Block) + b->level * sizeof(SkipLink); 
+     free(b); 
+ } 
+ 
  //把节点根据起始地址的升序，插入到全局链表里面 
- void insert_sorted(Block* node) { 
-   if (!node) return; 
-     if (!head) { 
-         head = node; 
-         return; 
+ //沿跳表逐层找到插入位置，O(log n)，不再从头遍历 
+ void insert_sorted(Arena* a, Block* node) { 
+     if (!node) return; 
+     Block* h = skip_header(a); 
+     Block* upd[Skip_Max_Level]; 
+     skip_path(a, node->startAddr, upd); 
+     if (node->level > a->skip_level) { 
+         for (int i = a->skip_level; i < node->level; ++i) upd[i] = h; 
+         a->skip_level = node->level; 
      } 
-     //插入到头部 
-     if (node->startAddr < head->startAddr) { 
-         node->next = head; 
-         head->prev = node; 
-         head = node; 
-         return; 
+     for (int i = 0; i < node->level; ++i) { 
+         node->link[i].next = upd[i]->link[i].next; 
+         upd[i]->link[i].next = node; 
+     } 
+     node->prev = upd[0] == h ? NULL : upd[0]; 
+     node->next = node->link[0].next; 
+     if (node->next) node->next->prev = node; 
+     if (node->prev) node->prev->next = node; 
+     else a->head = node; 
+     for (int i = 0; i < a->skip_level; ++i) { 
+         if (i < node->level) skip_recompute(node, i); 
+         skip_recompute(upd[i], i); 
      } 
-     //从前向后查找插入节点的位置 
-     Block* cur = head; 
-    while (cur->next && cur->next->startAddr < node->startAddr) cur = cur->next; 
-    node->next = cur->next; 
-    if (cur->next) cur->next->prev = node; 
-    cur->next = node; 
-    node->prev = cur; 
  } 
  
- //这里是实现首次适用算法的部分，需要按照块的大小，查找第一个可以放下need大小的字节的空闲块 
- Block* find_first_fit(int need) { 
-     Block* t = head; 
-     while (t) { 
-         if (t->free) { 
-             int sz = t->endAddr - t->startAddr + 1; 
-             if (sz >= need) return t; 
+ //释放arena中的所有块，清空跳表 
+ void arena_clear(Arena* a) { 
+     while (a->head) { Block* t = a->head; a->head = a->head->next; free_block(a, t); } 
+     if (a->skip_head) memset(a->skip_head->link, 0, Skip_Max_Level * sizeof(SkipLink)); 
+     a->skip_level = 1; 
+ } 
+ 
+ //从地址addr开始（含）查找第一个能放下need的空闲块 
+ //区间最大空闲块不够need就整段跳过，跳到下一个块后再爬到它的最高层，期望O(log n) 
+ Block* find_first_fit_from(Arena* a, Addr addr, Addr need) { 
+     Block* upd[Skip_Max_Level]; 
+     skip_path(a, addr, upd); 
+     Block* x = upd[0]->link[0].next; 
+     int i = x ? x->level - 1 : 0; 
+     while (x) { 
+         a->search_steps++; 
+         if (x->link[i].span_max >= need) { 
+             if (i == 0) return x; 
+             i--; 
+         } 
+         else { 
+             x = x->link[i].next; 
+             if (x) i = x->level - 1; 
          } 
-         t = t->next; 
      } 
      return NULL; 
  } 
  
+ //这里是实现首次适用算法的部分，需要按照块的大小，查找第一个可以放下need大小的字节的空闲块 
+ Block* find_first_fit(Arena* a, Addr need) { 
+     return find_first_fit_from(a, LLONG_MIN, need); 
+ } 
+ 
+ //循环首次适应：从last_addr向后查找，若向后未找到则从头开始查找（找到的一定在last_addr之前） 
+ Block* find_next_fit(Arena* a, Addr need, Addr last_addr) { 
+     Block* t = find_first_fit_from(a, last_addr, need); 
+     if (!t) t = find_first_fit_from(a, LLONG_MIN, need); 
+     return t; 
+ } 
+ 
  //实现最佳适应算法，查找最小的可以放下need大小的空闲块 
- Block* find_best_fit(int need) { 
-     Block* t = head; 
+ Block* find_best_fit(Arena* a, Addr need) { 
+     Block* t = a->head; 
      Block* best = NULL; 
-     int best_size = M_S + 1; // 初始化为大于最大内存的值 
+     Addr best_size = a->size + 1; // 初始化为大于最大内存的值 
      while (t) { 
+         a->search_steps++; 
          if (t->free) { 
-             int sz = t->endAddr - t->startAddr + 1; 
+             Addr sz = t->endAddr - t->startAddr + 1; 
              if (sz >= need && sz < best_size) { 
                  best = t; 
                  best_size = sz; 
@@ -106,36 +351,29 @@
  } 
  
  //实现最坏适应算法，查找最大的可以放下need大小的空闲块 
- Block* find_worst_fit(int need) { 
-     Block* t = head; 
-     Block* worst = NULL; 
-     int worst_size = 0; 
-     while (t) { 
-         if (t->free) { 
-             int sz = t->endAddr - t->startAddr + 1; 
-             if (sz >= need && sz > worst_size) { 
-                 worst = t; 
-                 worst_size = sz; 
-             } 
-         } 
-         t = t->next; 
+ //最高层各区间的最大值就是全局最大空闲块，再用首次适应找到最靠前的那一块 
+ Block* find_worst_fit(Arena* a, Addr need) { 
+     int top = a->skip_level - 1; 
+     Addr worst_size = 0; 
+     for (Block* x = skip_header(a); x; x = x->link[top].next) { 
+         a->search_steps++; 
+         if (x->link[top].span_max > worst_size) worst_size = x->link[top].span_max; 
      } 
-     return worst; 
+     if (worst_size == 0 || worst_size < need) return NULL; 
+     return find_first_fit(a, worst_size); 
  } 
  
  //根据起始地址查找内存块，用于定位 
- Block* find_by_start(int start) { 
-     Block* t = head; 
-     while (t) { 
-         if (t->startAddr == start) return t; 
-         t = t->next; 
-     } 
-     return NULL; 
+ Block* find_by_start(Arena* a, Addr start) { 
+     Block* upd[Skip_Max_Level]; 
+     skip_path(a, start, upd); 
+     Block* t = upd[0]->link[0].next; 
+     return t && t->startAddr == start ? t : NULL; 
  } 
  
  //根据块ID查找内存块，也是用于定位 
- Block* find_by_id(int id) { 
-     Block* t = head; 
+ Block* find_by_id(Arena* a, int id) { 
+     Block* t = a->head; 
      while (t) { 
          if (t->id == id) return t; 
          t = t->next; 
@@ -144,21 +382,21 @@
  } 
  
  //打印现在各个内存块的状态 
- void print_state() { 
+ void print_state(Arena* a) { 
      printf("空闲块 起始地址 大小\n"); 
-     Block* t = head; 
+     Block* t = a->head; 
      while (t) { 
          if (t->free) { 
-             printf("%6d %9d %5d\n", t->id, t->startAddr, t->endAddr - t->startAddr + 1); 
+             printf("%6d %9lld %5lld\n", t->id, t->startAddr, t->endAddr - t->startAddr + 1); 
          } 
          t = t->next; 
      } 
      printf("————————————————————————————————————————————————————\n"); 
      printf("已用的块 起始地址 大小 进程号\n"); 
-     t = head; 
+     t = a->head; 
      while (t) { 
          if (!t->free) { 
-             printf("%6d %9d %5d %6d\n", t->id, t->startAddr, t->endAddr - t->startAddr + 1, t->pid); 
+             printf("%6d %9lld %5lld %6d\n", t->id, t->startAddr, t->endAddr - t->startAddr + 1, t->pid); 
          } 
          t = t->next; 
      } 
@@ -167,43 +405,65 @@
  
  //这里是将选出的空闲块作为target，按照请求的大小req，进行随机起始地址的分配，并且分割成三块，剩余块、分配块、剩余块； 
  //随机选择好起始地址，将选出的空闲块target删除，然后将分割后的三块插入链表 
- Block* split_and_alloc(Block* target, int req) { 
+ Block* split_and_alloc(Arena* a, Block* target, int req) { 
      if (!target) return NULL; 
-     int bsize = target->endAddr - target->startAddr + 1; 
+     Addr bsize = target->endAddr - target->startAddr + 1; 
      if (req > bsize) return NULL; 
-     int maxStart = target->endAddr - req + 1; 
-     int allocStart = target->startAddr + (rand() % (maxStart - target->startAddr + 1)); 
-     int allocEnd = allocStart + req - 1; 
-     remove_node(target); 
+     Addr maxStart = target->endAddr - req + 1; 
+     Addr allocStart; 
+     if (a->placement == PLACE_EDGE) allocStart = a->place_high ? maxStart : target->startAddr; 
+     else allocStart = target->startAddr + arena_rand_below(a, maxStart - target->startAddr + 1); 
+     Addr allocEnd = allocStart + req - 1; 
+     remove_node(a, target); 
      if (target->startAddr <= allocStart - 1) { 
-         Block* left = new_block(target->startAddr, allocStart - 1, true, -1); 
-         insert_sorted(left); 
+         Block* left = new_block(a, target->startAddr, allocStart - 1, true, -1); 
+         insert_sorted(a, left); 
      } 
-     Block* alloc = new_block(allocStart, allocEnd, false, -1); 
-     insert_sorted(alloc); 
+     Block* alloc = new_block(a, allocStart, allocEnd, false, -1); 
+     insert_sorted(a, alloc); 
      if (allocEnd + 1 <= target->endAddr) { 
-         Block* right = new_block(allocEnd + 1, target->endAddr, true, -1); 
-         insert_sorted(right); 
+         Block* right = new_block(a, allocEnd + 1, target->endAddr, true, -1); 
+         insert_sorted(a, right); 
      } 
-     free(target); 
+     free_block(a, target); 
      return alloc; 
  } 
  
  //遍历内存块链表，检查当前块和下一块是否同时满足空闲且两者地址连续；若满足，将两块合并：更新当前块的结束地址为下一块的结束地址，删除下一块节点并释放内存；若不满足，继续遍历下一个节点 
- void combine_free() { 
-     Block* t = head; 
+ void combine_free(Arena* a) { 
+     Block* t = a->head; 
      while (t && t->next) { 
          if (t->free && t->next->free && t->endAddr + 1 == t->next->startAddr) { 
              Block* nxt = t->next; 
              t->endAddr = nxt->endAddr; 
-             t->next = nxt->next; 
-             if (nxt->next) nxt->next->prev = t; 
-             free(nxt); 
+             remove_node(a, nxt); 
+             free_block(a, nxt); 
          } 
          else { 
              t = t->next; 
          } 
      } 
+     skip_rebuild(a); 
+ } 
+ 
+ //回收块b，只和左右相邻的空闲块合并，O(log n) 
+ //要求链表中原本没有相邻的空闲块，即之前的回收都已合并过 
+ void coalesce_block(Arena* a, Block* b) { 
+     b->free = true; 
+     Block* nxt = b->next; 
+     if (nxt && nxt->free && b->endAddr + 1 == nxt->startAddr) { 
+         b->endAddr = nxt->endAddr; 
+         remove_node(a, nxt); 
+         free_block(a, nxt); 
+     } 
+     Block* prv = b->prev; 
+     if (prv && prv->free && prv->endAddr + 1 == b->startAddr) { 
+         prv->endAddr = b->endAddr; 
+         remove_node(a, b); 
+         free_block(a, b); 
+         b = prv; 
+     } 
+     skip_fix(a, b); 
  } 
  
  //这里是打印题目中所要求的十个进程所需要的内存 
@@ -218,9 +478,10 @@
  //首次适应算法的实现 
  void first_fit(int reqs[], int n) { 
      printf("———————————— 首次适应算法 (FF) ————————————\n"); 
-     while (head) { Block* t = head; head = head->next; free(t); } //要先清理旧的链表 
-     Block_ID = 0; 
-     head = new_block(0, M_S - 1, true, -1);//初始化了一个空闲的块 
+     Arena* a = &main_arena; 
+     arena_clear(a);//要先清理旧的链表 
+     a->Block_ID = 0; 
+     insert_sorted(a, new_block(a, 0, M_S - 1, true, -1));//初始化了一个空闲的块 
      PCB* pcb_head = NULL; 
      PCB* pcb_tail = NULL; 
      for (int i = 0; i < n; ++i) { 
@@ -234,17 +495,17 @@
          else { pcb_tail->next = p; pcb_tail = p; } 
      } 
      printf("初始内存状态:\n"); 
-     print_state(); 
+     print_state(a); 
      //这是为每个进程分配内存的环节 
      PCB* p = pcb_head; 
      while (p) { 
          printf("为进程 %d 分配内存, 需求=%d 字节\n", p->pid, p->req); 
-         Block* candidate = find_first_fit(p->req); 
+         Block* candidate = find_first_fit(a, p->req); 
          if (!candidate) { 
              printf("分配失败: 没有足够大的空闲分区!\n"); 
          } 
          else { 
-             Block* alloc = split_and_alloc(candidate, p->req); 
+             Block* alloc = split_and_alloc(a, candidate, p->req); 
              if (alloc) { 
                  alloc->pid = p->pid; 
                  p->blockID = alloc->id; 
@@ -256,7 +517,7 @@
              } 
          } 
          printf("————————————————————————————————————————\n"); 
-         print_state(); 
+         print_state(a); 
          p = p->next; 
      } 
      // 按PCB顺序回收已经分配的分块 
@@ -265,28 +526,28 @@
      while (p) { 
          if (p->status == 1 && p->blockID != -1) { 
              printf("回收进程 %d 所占用的内存（块ID=%d）...\n", p->pid, p->blockID); 
-             Block* blk = find_by_id(p->blockID); 
+             Block* blk = find_by_id(a, p->blockID); 
              if (blk) { 
                  blk->free = true; 
                  blk->pid = -1; 
-                 combine_free();//回收后要尝试合并空闲块 
+                 combine_free(a);//回收后要尝试合并空闲块 
              } 
              printf("————————————————————————————————————————\n"); 
-             print_state(); 
+             print_state(a); 
          } 
          p = p->next; 
      } 
      while (pcb_head) { PCB* tmp = pcb_head; pcb_head = pcb_head->next; free(tmp); } 
-     while (head) { Block* tmp = head; head = head->next; free(tmp); }//清理内存，释放所有的节点 
-     head = NULL; 
+     arena_clear(a);//清理内存，释放所有的节点 
  } 
  
  //循环首次适应算法的实现 
  void next_fit(int reqs[], int n) { 
      printf("———————————— 循环首次适应算法 (NF) ————————————\n"); 
-     while (head) { Block* t = head; head = head->next; free(t); }//清理旧链表 
-     Block_ID = 0; 
-     head = new_block(0, M_S - 1, true, -1); 
+     Arena* a = &main_arena; 
+     arena_clear(a);//清理旧链表 
+     a->Block_ID = 0; 
+     insert_sorted(a, new_block(a, 0, M_S - 1, true, -1)); 
      PCB* pcb_head = NULL; 
      PCB* pcb_tail = NULL; 
      for (int i = 0; i < n; ++i) { 
@@ -300,35 +561,17 @@
          else { pcb_tail->next = p; pcb_tail = p; } 
      } 
      printf("初始内存状态:\n"); 
-     print_state(); 
-     int last_addr = 0;//这里是与FF的区别，用last_addr记录下一次查找的起始地址，从last_addr开始向后查找符合条件的空闲块，若向后未找到则从头开始查找到last_addr之前 
+     print_state(a); 
+     Addr last_addr = 0;//这里是与FF的区别，用last_addr记录下一次查找的起始地址，从last_addr开始向后查找符合条件的空闲块，若向后未找到则从头开始查找到last_addr之前 
      PCB* p = pcb_head; 
      while (p) { 
          printf("为进程 %d 分配内存, 需求=%d 字节\n", p->pid, p->req); 
-         Block* candidate = NULL; 
-         Block* t = head; 
-         while (t) { 
-             if (t->startAddr >= last_addr && t->free) { 
-                 int bsize = t->endAddr - t->startAddr + 1; 
-                 if (bsize >= p->req) { candidate = t; break; } 
-             } 
-             t = t->next; 
-         } 
-         if (!candidate) { 
-             t = head; 
-             while (t && t->startAddr < last_addr) { 
-                 if (t->free) { 
-                     int bsize = t->endAddr - t->startAddr + 1; 
-                     if (bsize >= p->req) { candidate = t; break; } 
-                 } 
-                 t = t->next; 
-             } 
-         } 
+         Block* candidate = find_next_fit(a, p->req, last_addr); 
          if (!candidate) { 
              printf("分配失败: 没有足够大的空闲分区!\n"); 
          } 
          else { 
-             Block* alloc = split_and_alloc(candidate, p->req); 
+             Block* alloc = split_and_alloc(a, candidate, p->req); 
              if (alloc) { 
                  alloc->pid = p->pid; 
                  p->blockID = alloc->id; 
@@ -342,7 +585,7 @@
              } 
          } 
          printf("————————————————————————————————————————\n"); 
-         print_state(); 
+         print_state(a); 
          p = p->next; 
      } 
      // 按PCB顺序回收 
@@ -351,29 +594,29 @@
      while (p) { 
          if (p->status == 1 && p->blockID != -1) { 
              printf("回收进程 %d 所占用的内存（块ID=%d）...\n", p->pid, p->blockID); 
-             Block* blk = find_by_id(p->blockID); 
+             Block* blk = find_by_id(a, p->blockID); 
              if (blk) { 
                  blk->free = true; 
                  blk->pid = -1; 
-                 combine_free(); 
+                 combine_free(a); 
              } 
              printf("—————————————————————————————————————\n"); 
-             print_state(); 
+             print_state(a); 
          } 
          p = p->next; 
      } 
      //与FF算法的实现相同，也要清理内存 
      while (pcb_head) { PCB* tmp = pcb_head; pcb_head = pcb_head->next; free(tmp); } 
-     while (head) { Block* tmp = head; head = head->next; free(tmp); } 
-     head = NULL; 
+     arena_clear(a); 
  } 
  
  //最佳适应算法的实现 
  void best_fit(int reqs[], int n) { 
      printf("———————————— 最佳适应算法 (BF) ————————————\n"); 
-     while (head) { Block* t = head; head = head->next; free(t); } 
-     Block_ID = 0; 
-     head = new_block(0, M_S - 1, true, -1); 
+     Arena* a = &main_arena; 
+     arena_clear(a); 
+     a->Block_ID = 0; 
+     insert_sorted(a, new_block(a, 0, M_S - 1, true, -1)); 
      PCB* pcb_head = NULL; 
      PCB* pcb_tail = NULL; 
      for (int i = 0; i < n; ++i) { 
@@ -387,16 +630,16 @@
          else { pcb_tail->next = p; pcb_tail = p; } 
      } 
      printf("初始内存状态:\n"); 
-     print_state(); 
+     print_state(a); 
      PCB* p = pcb_head; 
      while (p) { 
          printf("为进程 %d 分配内存, 需求=%d 字节\n", p->pid, p->req); 
-         Block* candidate = find_best_fit(p->req); 
+         Block* candidate = find_best_fit(a, p->req); 
          if (!candidate) { 
              printf("分配失败: 没有足够大的空闲分区!\n"); 
          } 
          else { 
-             Block* alloc = split_and_alloc(candidate, p->req); 
+             Block* alloc = split_and_alloc(a, candidate, p->req); 
              if (alloc) { 
                  alloc->pid = p->pid; 
                  p->blockID = alloc->id; 
@@ -408,7 +651,7 @@
              } 
          } 
          printf("————————————————————————————————————————\n"); 
-         print_state(); 
+         print_state(a); 
          p = p->next; 
      } 
      printf("———————————— BF 回收阶段 ————————————\n"); 
@@ -416,28 +659,28 @@
      while (p) { 
          if (p->status == 1 && p->blockID != -1) { 
              printf("回收进程 %d 所占用的内存（块ID=%d）...\n", p->pid, p->blockID); 
-             Block* blk = find_by_id(p->blockID); 
+             Block* blk = find_by_id(a, p->blockID); 
              if (blk) { 
                  blk->free = true; 
                  blk->pid = -1; 
-                 combine_free(); 
+                 combine_free(a); 
              } 
              printf("————————————————————————————————————————\n"); 
-             print_state(); 
+             print_state(a); 
          } 
          p = p->next; 
      } 
      while (pcb_head) { PCB* tmp = pcb_head; pcb_head = pcb_head->next; free(tmp); } 
-     while (head) { Block* tmp = head; head = head->next; free(tmp); } 
-     head = NULL; 
+     arena_clear(a); 
  } 
  
  //最坏适应算法的实现 
  void worst_fit(int reqs[], int n) { 
      printf("———————————— 最坏适应算法 (WF) ————————————\n"); 
-     while (head) { Block* t = head; head = head->next; free(t); } 
-     Block_ID = 0; 
-     head = new_block(0, M_S - 1, true, -1); 
+     Arena* a = &main_arena; 
+     arena_clear(a); 
+     a->Block_ID = 0; 
+     insert_sorted(a, new_block(a, 0, M_S - 1, true, -1)); 
      PCB* pcb_head = NULL; 
      PCB* pcb_tail = NULL; 
      for (int i = 0; i < n; ++i) { 
@@ -451,16 +694,16 @@
          else { pcb_tail->next = p; pcb_tail = p; } 
      } 
      printf("初始内存状态:\n"); 
-     print_state(); 
+     print_state(a); 
      PCB* p = pcb_head; 
      while (p) { 
          printf("为进程 %d 分配内存, 需求=%d 字节\n", p->pid, p->req); 
-         Block* candidate = find_worst_fit(p->req); 
+         Block* candidate = find_worst_fit(a, p->req); 
          if (!candidate) { 
              printf("分配失败: 没有足够大的空闲分区!\n"); 
          } 
          else { 
-             Block* alloc = split_and_alloc(candidate, p->req); 
+             Block* alloc = split_and_alloc(a, candidate, p->req); 
              if (alloc) { 
                  alloc->pid = p->pid; 
                  p->blockID = alloc->id; 
@@ -472,7 +715,7 @@
              } 
          } 
          printf("————————————————————————————————————————\n"); 
-         print_state(); 
+         print_state(a); 
          p = p->next; 
      } 
      printf("———————————— WF 回收阶段 ————————————\n"); 
@@ -480,23 +723,2483 @@
      while (p) { 
          if (p->status == 1 && p->blockID != -1) { 
              printf("回收进程 %d 所占用的内存（块ID=%d）...\n", p->pid, p->blockID); 
-             Block* blk = find_by_id(p->blockID); 
+             Block* blk = find_by_id(a, p->blockID); 
              if (blk) { 
                  blk->free = true; 
                  blk->pid = -1; 
-                 combine_free(); 
+                 combine_free(a); 
              } 
              printf("————————————————————————————————————————\n"); 
-             print_state(); 
+             print_state(a); 
          } 
          p = p->next; 
      } 
      while (pcb_head) { PCB* tmp = pcb_head; pcb_head = pcb_head->next; free(tmp); } 
-     while (head) { Block* tmp = head; head = head->next; free(tmp); } 
-     head = NULL; 
+     arena_clear(a); 
+ } 
+ 
+ //———————————————————————————— 多线程模式 ———————————————————————————— 
+ 
+ //初始化arena，整个区间作为一个空闲块 
+ void arena_init(Arena* a, int id, Addr baseAddr, Addr size, unsigned int rng, bool shared) { 
+     a->id = id; 
+     a->baseAddr = baseAddr; 
+     a->size = size; 
+     a->Block_ID = 0; 
+     a->rng = rng; 
+     a->shared = shared; 
+     a->head = NULL; 
+     a->skip_head = NULL; 
+     a->skip_level = 1; 
+     a->skip_rng = rng ? rng ^ 0x2545f491u : 0; 
+     a->meta_bytes = 0; 
+     a->meta_peak = 0; 
+     a->fit = FIT_FIRST; 
+     a->last_addr = baseAddr; 
+     a->placement = PLACE_RANDOM; 
+     a->place_high = false; 
+     a->search_steps = 0; 
+     insert_sorted(a, new_block(a, baseAddr, baseAddr + size - 1, true, -1)); 
+     pthread_mutex_init(&a->lock, NULL); 
+     atomic_init(&a->remote_free, NULL); 
+     a->lock_acquires = 0; 
+     a->lock_contended = 0; 
+     atomic_init(&a->remote_pushes, 0); 
+     atomic_init(&a->remote_cas_retries, 0); 
+     a->remote_drains = 0; 
+     a->quick_threshold = 0; 
+     a->quick_count = 0; 
+     memset(a->quick, 0, sizeof(a->quick)); 
+     a->quick_hits = 0; 
+     a->consolidations = 0; 
+ } 
+ 
+ void arena_destroy(Arena* a) { 
+     arena_clear(a); 
+     if (a->skip_head) free_block(a, a->skip_head); 
+     a->skip_head = NULL; 
+     pthread_mutex_destroy(&a->lock); 
+ } 
+ 
+ //加锁，先trylock，失败说明有竞争，再阻塞等待 
+ void arena_lock(Arena* a) { 
+     if (pthread_mutex_trylock(&a->lock) != 0) { 
+         pthread_mutex_lock(&a->lock); 
+         a->lock_contended++; 
+     } 
+     a->lock_acquires++; 
+ } 
+ 
+ void arena_unlock(Arena* a) { 
+     pthread_mutex_unlock(&a->lock); 
+ } 
+ 
+ //把快速链表中的块全部标记为空闲，然后只做一次合并 
+ void arena_consolidate(Arena* a) { 
+     for (int i = 0; i < Quick_Bins; ++i) { 
+         Block* b = a->quick[i]; 
+         while (b) { 
+             Block* nxt = b->quick_next; 
+             b->quick_next = NULL; 
+             b->free = true; 
+             b = nxt; 
+         } 
+         a->quick[i] = NULL; 
+     } 
+     a->quick_count = 0; 
+     combine_free(a); 
+     a->consolidations++; 
+ } 
+ 
+ //从快速链表取一个能放下req的块，整块复用不再切分 
+ Block* quick_take(Arena* a, int req) { 
+     int bin = req / Quick_Bin_Width; 
+     for (int i = bin; i <= bin + 1 && i < Quick_Bins; ++i) { 
+         Block** pp = &a->quick[i]; 
+         while (*pp) { 
+             Block* b = *pp; 
+             if (b->endAddr - b->startAddr + 1 >= req) { 
+                 *pp = b->quick_next; 
+                 b->quick_next = NULL; 
+                 a->quick_count--; 
+                 a->quick_hits++; 
+                 return b; 
+             } 
+             pp = &b->quick_next; 
+         } 
+     } 
+     return NULL; 
+ } 
+ 
+ //回收一个块，调用者必须是arena的属主或持有arena的锁 
+ //立即合并模式下合并相邻空闲块；延迟合并模式下小块先挂到快速链表 
+ void arena_release(Arena* a, Block* b) { 
+     Addr sz = b->endAddr - b->startAddr + 1; 
+     b->pid = -1; 
+     if (a->quick_threshold > 0 && sz <= Quick_Max_Size) { 
+         int bin = (int)(sz / Quick_Bin_Width); 
+         b->quick_next = a->quick[bin]; 
+         a->quick[bin] = b; 
+         if (++a->quick_count >= a->quick_threshold) arena_consolidate(a); 
+         return; 
+     } 
+     coalesce_block(a, b); 
+ } 
+ 
+ //非属主线程释放块：用CAS把块压入属主arena的队列，不碰属主的链表 
+ void remote_free_push(Arena* owner, Block* b) { 
+     Block* old = atomic_load_explicit(&owner->remote_free, memory_order_relaxed); 
+     do { 
+         b->remote_next = old; 
+         if (atomic_compare_exchange_weak_explicit(&owner->remote_free, &old, b, 
+                 memory_order_release, memory_order_relaxed)) break; 
+         atomic_fetch_add_explicit(&owner->remote_cas_retries, 1, memory_order_relaxed); 
+     } while (true); 
+     atomic_fetch_add_explicit(&owner->remote_pushes, 1, memory_order_relaxed); 
+ } 
+ 
+ //属主线程一次取走整个队列，逐个回收，只在最后合并一次 
+ void remote_free_drain(Arena* a) { 
+     if (!atomic_load_explicit(&a->remote_free, memory_order_relaxed)) return; 
+     Block* b = atomic_exchange_explicit(&a->remote_free, NULL, memory_order_acquire); 
+     if (!b) return; 
+     while (b) { 
+         Block* nxt = b->remote_next; 
+         b->remote_next = NULL; 
+         b->free = true; 
+         b->pid = -1; 
+         b = nxt; 
+     } 
+     combine_free(a); 
+     a->remote_drains++; 
+ } 
+ 
+ //从高地址往低地址找第一个能放下need的空闲块，和首次适应对称 
+ //每层在上一层选中的区间内找最后一个够大的子区间，期望O(log n) 
+ Block* find_last_fit(Arena* a, Addr need) { 
+     Block* x = skip_header(a); 
+     Block* end = NULL; 
+     for (int i = a->skip_level - 1; i >= 0; --i) { 
+         Block* last = NULL; 
+         for (Block* y = x; y != end; y = y->link[i].next) { 
+             a->search_steps++; 
+             if (y->link[i].span_max >= need) last = y; 
+         } 
+         if (!last) return NULL; 
+         x = last; 
+         end = last->link[i].next; 
+     } 
+     return x == skip_header(a) ? NULL : x; 
+ } 
+ 
+ //寿命分区：短寿命对象从低地址、长寿命对象从高地址找，两类对象各自聚在一端 
+ Block* find_lifetime_fit(Arena* a, Addr need, bool long_lived) { 
+     return long_lived ? find_last_fit(a, need) : find_first_fit(a, need); 
+ } 
+ 
+ //按arena的放置策略查找空闲块，long_lived只对寿命分区策略有意义 
+ Block* arena_find(Arena* a, int req, bool long_lived) { 
+     switch (a->fit) { 
+     case FIT_LIFETIME: return find_lifetime_fit(a, req, long_lived); 
+     case FIT_NEXT: return find_next_fit(a, req, a->last_addr); 
+     case FIT_BEST: return find_best_fit(a, req); 
+     case FIT_WORST: return find_worst_fit(a, req); 
+     default: return find_first_fit(a, req); 
+     } 
+ } 
+ 
+ //在arena中按放置策略分配，失败时先收回跨线程释放的块、合并快速链表，再试一次 
+ //long_lived为调用者预测的寿命类别 
+ Block* arena_alloc_hint(Arena* a, int req, int pid, bool long_lived) { 
+     a->place_high = long_lived && a->fit == FIT_LIFETIME; 
+     Block* b = a->quick_count > 0 ? quick_take(a, req) : NULL; 
+     if (!b) b = split_and_alloc(a, arena_find(a, req, long_lived), req); 
+     if (!b && !a->shared) { 
+         remote_free_drain(a); 
+         b = split_and_alloc(a, arena_find(a, req, long_lived), req); 
+     } 
+     if (!b && a->quick_count > 0) { 
+         arena_consolidate(a); 
+         b = split_and_alloc(a, arena_find(a, req, long_lived), req); 
+     } 
+     if (b) { 
+         b->pid = pid; 
+         a->last_addr = b->endAddr + 1; 
+     } 
+     return b; 
+ } 
+ 
+ Block* arena_alloc(Arena* a, int req, int pid) { 
+     return arena_alloc_hint(a, req, pid, false); 
+ } 
+ 
+ typedef struct MTThread { 
+     pthread_t tid; 
+     int idx; 
+     Arena arena;//线程私有arena 
+     struct MTSim* sim; 
+     long ops; 
+     long allocs; 
+     long fallback_allocs;//私有arena放不下，转到共享arena的次数 
+     long fail_allocs; 
+     long local_frees; 
+     long remote_frees;//释放的块属于其他线程 
+     long shared_frees;//释放的块属于共享arena 
+     int live_n; 
+     Block* live[MT_Live_Slots]; 
+ } MTThread; 
+ 
+ typedef struct MTSim { 
+     int nthreads; 
+     long ops_per_thread; 
+     int remote_pct;//释放时放入交换槽的百分比 
+     Arena shared; 
+     MTThread* threads; 
+     int exchange_n; 
+     _Atomic(Block*) exchange[MT_Max_Threads * MT_Exchange_Per_Thread]; 
+ } MTSim; 
+ 
+ //按块的属主选择释放路径 
+ void mt_free(MTThread* t, Block* b) { 
+     Arena* owner = b->owner; 
+     if (owner == &t->arena) { 
+         arena_release(owner, b); 
+         t->local_frees++; 
+     } 
+     else if (owner->shared) { 
+         arena_lock(owner); 
+         arena_release(owner, b); 
+         arena_unlock(owner); 
+         t->shared_frees++; 
+     } 
+     else { 
+         remote_free_push(owner, b); 
+         t->remote_frees++; 
+     } 
+ } 
+ 
+ void* mt_worker(void* arg) { 
+     MTThread* t = (MTThread*)arg; 
+     MTSim* sim = t->sim; 
+     Arena* own = &t->arena; 
+     for (long i = 0; i < sim->ops_per_thread; ++i) { 
+         t->ops++; 
+         int r = arena_rand(own) % 100; 
+         if (t->live_n < MT_Live_Slots && (t->live_n == 0 || r < 55)) { 
+             int req = Min_R + arena_rand(own) % (Max_R - Min_R + 1); 
+             remote_free_drain(own); 
+             Block* b = arena_alloc(own, req, t->idx); 
+             if (!b) { 
+                 arena_lock(&sim->shared); 
+                 b = arena_alloc(&sim->shared, req, t->idx); 
+                 arena_unlock(&sim->shared); 
+                 if (b) t->fallback_allocs++; 
+             } 
+             if (b) { 
+                 t->live[t->live_n++] = b; 
+                 t->allocs++; 
+             } 
+             else { 
+                 t->fail_allocs++; 
+             } 
+         } 
+         else { 
+             int k = arena_rand(own) % t->live_n; 
+             Block* b = t->live[k]; 
+             t->live[k] = t->live[--t->live_n]; 
+             if (arena_rand(own) % 100 < sim->remote_pct) { 
+                 //放入随机交换槽，换出的块（可能来自任何线程）由本线程释放 
+                 int slot = arena_rand(own) % sim->exchange_n; 
+                 b = atomic_exchange_explicit(&sim->exchange[slot], b, memory_order_acq_rel); 
+                 if (!b) continue; 
+             } 
+             mt_free(t, b); 
+         } 
+     } 
+     while (t->live_n > 0) mt_free(t, t->live[--t->live_n]); 
+     return NULL; 
+ } 
+ 
+ //统计arena中的块数，回收完全后应只剩一个空闲块 
+ int arena_block_count(Arena* a, bool* all_free) { 
+     int n = 0; 
+     *all_free = true; 
+     for (Block* t = a->head; t; t = t->next) { 
+         n++; 
+         if (!t->free) *all_free = false; 
+     } 
+     return n; 
+ } 
+ 
+ double now_sec() { 
+     struct timespec ts; 
+     clock_gettime(CLOCK_MONOTONIC, &ts); 
+     return ts.tv_sec + ts.tv_nsec / 1e9; 
+ } 
+ 
+ long long now_ns() { 
+     struct timespec ts; 
+     clock_gettime(CLOCK_MONOTONIC, &ts); 
+     return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec; 
+ } 
+ 
+ //用nthreads个线程跑一轮，返回吞吐（ops/s），并打印这一轮的竞争统计 
+ double mt_run(int nthreads, long ops_per_thread, int remote_pct, unsigned int seed, bool verbose) { 
+     MTSim* sim = (MTSim*)calloc(1, sizeof(MTSim)); 
+     if (!sim) { perror("calloc"); exit(1); } 
+     sim->nthreads = nthreads; 
+     sim->ops_per_thread = ops_per_thread; 
+     sim->remote_pct = remote_pct; 
+     sim->threads = (MTThread*)calloc(nthreads, sizeof(MTThread)); 
+     if (!sim->threads) { perror("calloc"); exit(1); } 
+     sim->exchange_n = nthreads * MT_Exchange_Per_Thread; 
+     for (int i = 0; i < sim->exchange_n; ++i) atomic_init(&sim->exchange[i], NULL); 
+     //地址空间布局：先是各线程arena，最后是共享arena 
+     for (int i = 0; i < nthreads; ++i) { 
+         MTThread* t = &sim->threads[i]; 
+         t->idx = i; 
+         t->sim = sim; 
+         arena_init(&t->arena, i, i * MT_Arena_Size, MT_Arena_Size, seed * 2654435761u + i + 1, false); 
+     } 
+     arena_init(&sim->shared, -1, nthreads * MT_Arena_Size, MT_Shared_Size, 0, true); 
+ 
+     double t0 = now_sec(); 
+     for (int i = 0; i < nthreads; ++i) { 
+         if (pthread_create(&sim->threads[i].tid, NULL, mt_worker, &sim->threads[i]) != 0) { 
+             perror("pthread_create"); 
+             exit(1); 
+         } 
+     } 
+     for (int i = 0; i < nthreads; ++i) pthread_join(sim->threads[i].tid, NULL); 
+     double elapsed = now_sec() - t0; 
+ 
+     //所有线程结束后，回收交换槽里剩下的块，并收回各arena队列 
+     for (int i = 0; i < sim->exchange_n; ++i) { 
+         Block* b = atomic_exchange(&sim->exchange[i], NULL); 
+         if (b) { 
+             if (b->owner->shared) arena_release(b->owner, b); 
+             else remote_free_push(b->owner, b); 
+         } 
+     } 
+     long ops = 0, allocs = 0, fallback = 0, fails = 0, local = 0, remote = 0, shared_frees = 0; 
+     long pushes = 0, retries = 0, drains = 0; 
+     bool consistent = true; 
+     for (int i = 0; i < nthreads; ++i) { 
+         MTThread* t = &sim->threads[i]; 
+         remote_free_drain(&t->arena); 
+         bool all_free; 
+         if (arena_block_count(&t->arena, &all_free) != 1 || !all_free) consistent = false; 
+         ops += t->ops; 
+         allocs += t->allocs; 
+         fallback += t->fallback_allocs; 
+         fails += t->fail_allocs; 
+         local += t->local_frees; 
+         remote += t->remote_frees; 
+         shared_frees += t->shared_frees; 
+         pushes += atomic_load(&t->arena.remote_pushes); 
+         retries += atomic_load(&t->arena.remote_cas_retries); 
+         drains += t->arena.remote_drains; 
+     } 
+     bool shared_free; 
+     if (arena_block_count(&sim->shared, &shared_free) != 1 || !shared_free) consistent = false; 
+     double throughput = ops / elapsed; 
+     if (verbose) { 
+         long frees = local + remote + shared_frees; 
+         printf("线程数 %d: 总操作 %ld, 耗时 %.3f s, 吞吐 %.0f ops/s\n", nthreads, ops, elapsed, throughput); 
+         printf("  分配 %ld, 转共享arena %ld (%.2f%%), 失败 %ld\n", allocs, fallback, 
+                allocs ? 100.0 * fallback / allocs : 0.0, fails); 
+         printf("  释放 %ld: 本地 %ld, 跨线程 %ld (%.2f%%), 共享arena %ld\n", frees, local, remote, 
+                frees ? 100.0 * remote / frees : 0.0, shared_frees); 
+         printf("  共享arena加锁 %ld 次, 其中竞争 %ld 次 (%.2f%%)\n", sim->shared.lock_acquires, 
+                sim->shared.lock_contended, 
+                sim->shared.lock_acquires ? 100.0 * sim->shared.lock_contended / sim->shared.lock_acquires : 0.0); 
+         printf("  跨线程释放队列: 压入 %ld, CAS重试 %ld, 属主收回批次 %ld\n", pushes, retries, drains); 
+         printf("  回收一致性检查: %s\n", consistent ? "通过" : "失败"); 
+     } 
+     for (int i = 0; i < nthreads; ++i) arena_destroy(&sim->threads[i].arena); 
+     arena_destroy(&sim->shared); 
+     free(sim->threads); 
+     free(sim); 
+     return throughput; 
+ } 
+ 
+ //多线程模式入口：线程数从1倍增到max_threads，输出可扩展性 
+ int run_mt(int argc, char* argv[]) { 
+     int max_threads = argc >= 3 ? atoi(argv[2]) : 8; 
+     long ops = argc >= 4 ? atol(argv[3]) : 200000; 
+     int remote_pct = argc >= 5 ? atoi(argv[4]) : 30; 
+     unsigned int seed = argc >= 6 ? (unsigned int)atoi(argv[5]) : (unsigned int)time(NULL); 
+     if (max_threads < 1) max_threads = 1; 
+     if (max_threads > MT_Max_Threads) max_threads = MT_Max_Threads; 
+     if (remote_pct < 0) remote_pct = 0; 
+     if (remote_pct > 100) remote_pct = 100; 
+     printf("———————————— 多线程arena模拟 ————————————\n"); 
+     printf("随机种子: %u, 每线程操作数: %ld, 跨线程交换比例: %d%%\n", seed, ops, remote_pct); 
+     printf("每线程arena %d 字节, 共享后备arena %d 字节, 请求大小 %d-%d\n\n", MT_Arena_Size, MT_Shared_Size, Min_R, Max_R); 
+     double base = 0; 
+     double tp[8]; 
+     int counts[8]; 
+     int nc = 0; 
+     for (int n = 1; n <= max_threads; n *= 2) counts[nc++] = n; 
+     if (counts[nc - 1] != max_threads) counts[nc++] = max_threads; 
+     for (int i = 0; i < nc; ++i) { 
+         tp[i] = mt_run(counts[i], ops, remote_pct, seed, true); 
+         if (i == 0) base = tp[i]; 
+         printf("\n"); 
+     } 
+     printf("线程数 吞吐(ops/s) 加速比 并行效率\n"); 
+     for (int i = 0; i < nc; ++i) { 
+         printf("%6d %12.0f %6.2f %7.1f%%\n", counts[i], tp[i], tp[i] / base, 100.0 * tp[i] / base / counts[i]); 
+     } 
+     return 0; 
+ } 
+ 
+ //———————————————————————————— 小对象尺寸类：无锁空闲栈 + 线程magazine ———————————————————————————— 
+ 
+ //尺寸类表可以换成classes子命令按负载生成的头文件：gcc -DSLAB_CLASS_HEADER='"slab_classes.h"' ... 
+ #ifdef SLAB_CLASS_HEADER 
+ #include SLAB_CLASS_HEADER 
+ _Static_assert(Slab_Generated_Classes == Slab_Classes, "生成的尺寸类个数必须等于Slab_Classes"); 
+ #else 
+ static const int slab_class_size[Slab_Classes] = { 16, 32, 48, 64, 96, 128, 192, 256 }; 
+ #endif 
+ 
+ //一个尺寸类：区间被切成nobjs个等长对象，空闲对象组成Treiber栈 
+ typedef struct SlabClass { 
+     int size;//对象大小 
+     int baseAddr;//区间起始地址 
+     int nobjs; 
+     _Atomic uint64_t top;//栈顶，高32位为版本号，低32位为对象下标+1，0表示空栈 
+     _Atomic int* next;//next[i]为对象i在栈中的下一个对象下标，-1表示栈底 
+     atomic_long cas_retries; 
+ } SlabClass; 
+ 
+ //带版本号的栈顶，每次修改版本号加一，防止ABA 
+ #define TAG_PTR(ver, idx) (((uint64_t)(ver) << 32) | (uint32_t)((idx) + 1)) 
+ #define TAG_IDX(v) ((int)((v) & 0xffffffffu) - 1) 
+ #define TAG_VER(v) ((uint32_t)((v) >> 32)) 
+ 
+ //返回能放下req字节的最小尺寸类，超出小对象范围返回-1 
+ int slab_class_of(int req) { 
+     for (int c = 0; c < Slab_Classes; ++c) { 
+         if (slab_class_size[c] >= req) return c; 
+     } 
+     return -1; 
+ } 
+ 
+ void treiber_push(SlabClass* c, int idx) { 
+     uint64_t old = atomic_load_explicit(&c->top, memory_order_relaxed); 
+     while (true) { 
+         atomic_store_explicit(&c->next[idx], TAG_IDX(old), memory_order_relaxed); 
+         uint64_t nv = TAG_PTR(TAG_VER(old) + 1, idx); 
+         if (atomic_compare_exchange_weak_explicit(&c->top, &old, nv, 
+                 memory_order_release, memory_order_relaxed)) return; 
+         atomic_fetch_add_explicit(&c->cas_retries, 1, memory_order_relaxed); 
+     } 
+ } 
+ 
+ //弹出栈顶对象，空栈返回-1 
+ //读到next之后、CAS之前，栈顶对象可能被别的线程弹出又压回（ABA），但版本号已经变了，CAS会失败重来 
+ int treiber_pop(SlabClass* c) { 
+     uint64_t old = atomic_load_explicit(&c->top, memory_order_acquire); 
+     while (true) { 
+         int idx = TAG_IDX(old); 
+         if (idx < 0) return -1; 
+         int nxt = atomic_load_explicit(&c->next[idx], memory_order_relaxed); 
+         uint64_t nv = TAG_PTR(TAG_VER(old) + 1, nxt); 
+         if (atomic_compare_exchange_weak_explicit(&c->top, &old, nv, 
+                 memory_order_acquire, memory_order_acquire)) return idx; 
+         atomic_fetch_add_explicit(&c->cas_retries, 1, memory_order_relaxed); 
+     } 
+ } 
+ 
+ //切分区间，所有对象压栈，下标0在栈顶 
+ void slab_class_init(SlabClass* c, int size, int baseAddr, int nobjs) { 
+     c->size = size; 
+     c->baseAddr = baseAddr; 
+     c->nobjs = nobjs; 
+     c->next = (_Atomic int*)malloc(sizeof(_Atomic int) * nobjs); 
+     if (!c->next) { perror("malloc"); exit(1); } 
+     for (int i = 0; i < nobjs; ++i) atomic_init(&c->next[i], i + 1 < nobjs ? i + 1 : -1); 
+     atomic_init(&c->top, TAG_PTR(0, 0)); 
+     atomic_init(&c->cas_retries, 0); 
+ } 
+ 
+ //统计栈中的对象数，回收完全后应等于nobjs 
+ int slab_class_free_count(SlabClass* c) { 
+     int n = 0; 
+     for (int i = TAG_IDX(atomic_load(&c->top)); i >= 0; i = atomic_load(&c->next[i])) n++; 
+     return n; 
+ } 
+ 
+ //线程私有的对象缓存，命中时不碰共享的栈 
+ typedef struct Magazine { 
+     int n; 
+     int objs[Mag_Size]; 
+ } Magazine; 
+ 
+ typedef struct SlabSim { 
+     int nthreads; 
+     long ops_per_thread; 
+     bool use_slab;//false为对照组：所有线程共用一条加锁的地址有序链表 
+     SlabClass cls[Slab_Classes]; 
+     Arena shared; 
+ } SlabSim; 
+ 
+ typedef struct SlabThread { 
+     pthread_t tid; 
+     int idx; 
+     unsigned int rng; 
+     SlabSim* sim; 
+     Magazine mag[Slab_Classes]; 
+     long ops; 
+     long allocs; 
+     long fails; 
+     long mag_hits;//直接从magazine拿到对象的次数 
+     long refills;//magazine为空，从栈批量取对象的次数 
+     long flushes;//magazine已满，批量还回栈的次数 
+     int live_n; 
+     int live_cls[Slab_Live_Slots]; 
+     int live_idx[Slab_Live_Slots]; 
+     Block* live_blk[Slab_Live_Slots]; 
+ } SlabThread; 
+ 
+ //从magazine取对象，空了就从栈里取半个magazine 
+ int slab_alloc(SlabThread* t, int c) { 
+     Magazine* m = &t->mag[c]; 
+     if (m->n > 0) { 
+         t->mag_hits++; 
+         return m->objs[--m->n]; 
+     } 
+     t->refills++; 
+     while (m->n < Mag_Size / 2) { 
+         int idx = treiber_pop(&t->sim->cls[c]); 
+         if (idx < 0) break; 
+         m->objs[m->n++] = idx; 
+     } 
+     return m->n > 0 ? m->objs[--m->n] : -1; 
+ } 
+ 
+ //还到magazine，满了先把一半还回栈 
+ void slab_free(SlabThread* t, int c, int idx) { 
+     Magazine* m = &t->mag[c]; 
+     if (m->n == Mag_Size) { 
+         t->flushes++; 
+         while (m->n > Mag_Size / 2) treiber_push(&t->sim->cls[c], m->objs[--m->n]); 
+     } 
+     m->objs[m->n++] = idx; 
+ } 
+ 
+ void slab_worker_free(SlabThread* t, int k) { 
+     if (t->sim->use_slab) { 
+         slab_free(t, t->live_cls[k], t->live_idx[k]); 
+     } 
+     else { 
+         arena_lock(&t->sim->shared); 
+         arena_release(&t->sim->shared, t->live_blk[k]); 
+         arena_unlock(&t->sim->shared); 
+     } 
+     t->live_cls[k] = t->live_cls[t->live_n - 1]; 
+     t->live_idx[k] = t->live_idx[t->live_n - 1]; 
+     t->live_blk[k] = t->live_blk[t->live_n - 1]; 
+     t->live_n--; 
+ } 
+ 
+ void* slab_worker(void* arg) { 
+     SlabThread* t = (SlabThread*)arg; 
+     SlabSim* sim = t->sim; 
+     for (long i = 0; i < sim->ops_per_thread; ++i) { 
+         t->ops++; 
+         int r = (int)(xorshift32(&t->rng) % 100); 
+         if (t->live_n < Slab_Live_Slots && (t->live_n == 0 || r < 55)) { 
+             int req = Slab_Min_R + (int)(xorshift32(&t->rng) % (Slab_Max_R - Slab_Min_R + 1)); 
+             int k = t->live_n; 
+             bool ok; 
+             if (sim->use_slab) { 
+                 int c = slab_class_of(req); 
+                 t->live_cls[k] = c; 
+                 t->live_idx[k] = slab_alloc(t, c); 
+                 ok = t->live_idx[k] >= 0; 
+             } 
+             else { 
+                 arena_lock(&sim->shared); 
+                 t->live_blk[k] = arena_alloc(&sim->shared, req, t->idx); 
+                 arena_unlock(&sim->shared); 
+                 ok = t->live_blk[k] != NULL; 
+             } 
+             if (ok) { 
+                 t->live_n++; 
+                 t->allocs++; 
+             } 
+             else { 
+                 t->fails++; 
+             } 
+         } 
+         else { 
+             slab_worker_free(t, (int)(xorshift32(&t->rng) % t->live_n)); 
+         } 
+     } 
+     while (t->live_n > 0) slab_worker_free(t, t->live_n - 1); 
+     if (sim->use_slab) { 
+         for (int c = 0; c < Slab_Classes; ++c) { 
+             while (t->mag[c].n > 0) treiber_push(&sim->cls[c], t->mag[c].objs[--t->mag[c].n]); 
+         } 
+     } 
+     return NULL; 
+ } 
+ 
+ typedef struct SlabResult { 
+     double throughput; 
+     double mag_hit_rate; 
+     long cas_retries; 
+     long lock_contended; 
+     long fails; 
+     bool consistent; 
+ } SlabResult; 
+ 
+ SlabResult slab_run(int nthreads, long ops_per_thread, bool use_slab, unsigned int seed) { 
+     SlabSim* sim = (SlabSim*)calloc(1, sizeof(SlabSim)); 
+     SlabThread* threads = (SlabThread*)calloc(nthreads, sizeof(SlabThread)); 
+     if (!sim || !threads) { perror("calloc"); exit(1); } 
+     sim->nthreads = nthreads; 
+     sim->ops_per_thread = ops_per_thread; 
+     sim->use_slab = use_slab; 
+     if (use_slab) { 
+         int addr = 0; 
+         for (int c = 0; c < Slab_Classes; ++c) { 
+             slab_class_init(&sim->cls[c], slab_class_size[c], addr, Slab_Objs_Per_Class); 
+             addr += slab_class_size[c] * Slab_Objs_Per_Class; 
+         } 
+     } 
+     else { 
+         arena_init(&sim->shared, -1, 0, nthreads * Slab_Live_Slots * Slab_Max_R * 2, 0, true); 
+     } 
+     for (int i = 0; i < nthreads; ++i) { 
+         threads[i].idx = i; 
+         threads[i].sim = sim; 
+         threads[i].rng = seed * 2654435761u + i + 1; 
+     } 
+     double t0 = now_sec(); 
+     for (int i = 0; i < nthreads; ++i) { 
+         if (pthread_create(&threads[i].tid, NULL, slab_worker, &threads[i]) != 0) { 
+             perror("pthread_create"); 
+             exit(1); 
+         } 
+     } 
+     for (int i = 0; i < nthreads; ++i) pthread_join(threads[i].tid, NULL); 
+     double elapsed = now_sec() - t0; 
+ 
+     SlabResult res = { 0 }; 
+     long ops = 0, hits = 0, allocs = 0; 
+     for (int i = 0; i < nthreads; ++i) { 
+         ops += threads[i].ops; 
+         hits += threads[i].mag_hits; 
+         allocs += threads[i].mag_hits + threads[i].refills; 
+         res.fails += threads[i].fails; 
+     } 
+     res.throughput = ops / elapsed; 
+     res.consistent = true; 
+     if (use_slab) { 
+         res.mag_hit_rate = allocs ? (double)hits / allocs : 0.0; 
+         for (int c = 0; c < Slab_Classes; ++c) { 
+             res.cas_retries += atomic_load(&sim->cls[c].cas_retries); 
+             if (slab_class_free_count(&sim->cls[c]) != sim->cls[c].nobjs) res.consistent = false; 
+             free((void*)sim->cls[c].next); 
+         } 
+     } 
+     else { 
+         bool all_free; 
+         if (arena_block_count(&sim->shared, &all_free) != 1 || !all_free) res.consistent = false; 
+         res.lock_contended = sim->shared.lock_contended; 
+         arena_destroy(&sim->shared); 
+     } 
+     free(threads); 
+     free(sim); 
+     return res; 
+ } 
+ 
+ //小对象模式入口：对比共享加锁链表和无锁尺寸类+magazine在不同线程数下的吞吐 
+ int run_slab(int argc, char* argv[]) { 
+     int max_threads = argc >= 3 ? atoi(argv[2]) : 8; 
+     long ops = argc >= 4 ? atol(argv[3]) : 100000; 
+     unsigned int seed = argc >= 5 ? (unsigned int)atoi(argv[4]) : (unsigned int)time(NULL); 
+     if (max_threads < 1) max_threads = 1; 
+     if (max_threads > MT_Max_Threads) max_threads = MT_Max_Threads; 
+     if (slab_class_size[Slab_Classes - 1] < Slab_Max_R) { 
+         fprintf(stderr, "最大的尺寸类 %d 小于小对象上限 %d\n", slab_class_size[Slab_Classes - 1], Slab_Max_R); 
+         return 1; 
+     } 
+     printf("———————————— 小对象尺寸类模拟 ————————————\n"); 
+     printf("随机种子: %u, 每线程操作数: %ld, 请求大小 %d-%d, magazine容量 %d\n", seed, ops, Slab_Min_R, Slab_Max_R, Mag_Size); 
+     printf("尺寸类:"); 
+     for (int c = 0; c < Slab_Classes; ++c) printf(" %d", slab_class_size[c]); 
+     printf("\n\n"); 
+     printf("线程数 共享链表(ops/s) 加速比 锁竞争 | 尺寸类(ops/s) 加速比 magazine命中率 CAS重试 | 一致性\n"); 
+     int counts[8]; 
+     int nc = 0; 
+     for (int n = 1; n <= max_threads; n *= 2) counts[nc++] = n; 
+     if (counts[nc - 1] != max_threads) counts[nc++] = max_threads; 
+     double base_list = 0, base_slab = 0; 
+     for (int i = 0; i < nc; ++i) { 
+         SlabResult list = slab_run(counts[i], ops, false, seed); 
+         SlabResult slab = slab_run(counts[i], ops, true, seed); 
+         if (i == 0) { 
+             base_list = list.throughput; 
+             base_slab = slab.throughput; 
+         } 
+         printf("%6d %16.0f %6.2f %6ld | %13.0f %6.2f %13.2f%% %7ld | %s\n", counts[i], 
+                list.throughput, list.throughput / base_list, list.lock_contended, 
+                slab.throughput, slab.throughput / base_slab, slab.mag_hit_rate * 100, slab.cas_retries, 
+                list.consistent && slab.consistent && list.fails == 0 && slab.fails == 0 ? "通过" : "失败"); 
+     } 
+     return 0; 
+ } 
+ 
+ //———————————————————————————— 立即合并与延迟合并对比 ———————————————————————————— 
+ 
+ //外部碎片率：1 - 最大空闲块 / 空闲总量，快速链表中的块也算空闲但不能与邻块拼成大块 
+ double arena_fragmentation(Arena* a) { 
+     Addr total = 0, largest = 0; 
+     for (Block* t = a->head; t; t = t->next) { 
+         if (t->free || t->pid == -1) { 
+             Addr sz = t->endAddr - t->startAddr + 1; 
+             total += sz; 
+             if (t->free && sz > largest) largest = sz; 
+         } 
+     } 
+     return total ? 1.0 - (double)largest / total : 0.0; 
+ } 
+ 
+ typedef struct ChurnResult { 
+     double throughput;//ops/s，不含采样时间 
+     double frag_avg; 
+     double frag_max; 
+     double internal_waste;//快速链表整块复用带来的内部碎片比例 
+     long fails; 
+     long consolidations; 
+     long quick_hits; 
+     long allocs; 
+ } ChurnResult; 
+ 
+ //单线程随机分配/释放，threshold为0表示立即合并，arena大小随live_slots放大 
+ ChurnResult churn_run(long ops, int threshold, FitPolicy fit, int live_slots, unsigned int seed) { 
+     Arena a; 
+     arena_init(&a, 0, 0, live_slots * Churn_Arena_Per_Slot, seed * 2654435761u + 1, false); 
+     a.quick_threshold = threshold; 
+     a.fit = fit; 
+     unsigned int wrng = seed + 0x9e3779b9u;//工作负载自己的随机数，保证不同策略看到相同的请求序列 
+     Block** live = (Block**)malloc(sizeof(Block*) * live_slots); 
+     if (!live) { perror("malloc"); exit(1); } 
+     int live_n = 0; 
+     ChurnResult res = { 0 }; 
+     long samples = 0; 
+     long req_bytes = 0, got_bytes = 0; 
+     double sample_time = 0; 
+     double t0 = now_sec(); 
+     for (long i = 0; i < ops; ++i) { 
+         int r = (int)(xorshift32(&wrng) % 100); 
+         if (live_n < live_slots && (live_n == 0 || r < 55)) { 
+             int req = Churn_Min_R + (int)(xorshift32(&wrng) % (Churn_Max_R - Churn_Min_R + 1)); 
+             Block* b = arena_alloc(&a, req, 0); 
+             if (b) { 
+                 live[live_n++] = b; 
+                 res.allocs++; 
+                 req_bytes += req; 
+                 got_bytes += b->endAddr - b->startAddr + 1; 
+             } 
+             else { 
+                 res.fails++; 
+             } 
+         } 
+         else { 
+             int k = (int)(xorshift32(&wrng) % live_n); 
+             arena_release(&a, live[k]); 
+             live[k] = live[--live_n]; 
+         } 
+         if (i % Churn_Sample_Every == 0) { 
+             double s0 = now_sec(); 
+             double f = arena_fragmentation(&a); 
+             res.frag_avg += f; 
+             if (f > res.frag_max) res.frag_max = f; 
+             samples++; 
+             sample_time += now_sec() - s0; 
+         } 
+     } 
+     double elapsed = now_sec() - t0 - sample_time; 
+     res.throughput = ops / elapsed; 
+     res.frag_avg = samples ? res.frag_avg / samples : 0.0; 
+     res.internal_waste = got_bytes ? 1.0 - (double)req_bytes / got_bytes : 0.0; 
+     res.consolidations = a.consolidations; 
+     res.quick_hits = a.quick_hits; 
+     free(live); 
+     arena_destroy(&a); 
+     return res; 
+ } 
+ 
+ //合并策略实验入口：相同请求序列下比较立即合并与不同阈值的延迟合并 
+ int run_coalesce(int argc, char* argv[]) { 
+     long ops = argc >= 3 ? atol(argv[2]) : 200000; 
+     unsigned int seed = argc >= 4 ? (unsigned int)atoi(argv[3]) : (unsigned int)time(NULL); 
+     static const int thresholds[] = { 0, 8, 32, 128 }; 
+     printf("———————————— 立即合并 vs 延迟合并 ————————————\n"); 
+     printf("随机种子: %u, 操作数: %ld, arena %d 字节, 请求大小 %d-%d, 快速链表收小于等于 %d 字节的块\n\n", 
+            seed, ops, Churn_Live_Slots * Churn_Arena_Per_Slot, Churn_Min_R, Churn_Max_R, Quick_Max_Size); 
+     printf("策略           吞吐(ops/s) 相对立即合并 平均外部碎片 最大外部碎片 内部碎片 分配失败 快速链表命中 批量合并次数\n"); 
+     double base = 0; 
+     for (int i = 0; i < (int)(sizeof(thresholds) / sizeof(thresholds[0])); ++i) { 
+         ChurnResult r = churn_run(ops, thresholds[i], FIT_FIRST, Churn_Live_Slots, seed); 
+         if (i == 0) base = r.throughput; 
+         char name[32]; 
+         if (thresholds[i] == 0) snprintf(name, sizeof(name), "立即合并"); 
+         else snprintf(name, sizeof(name), "延迟合并(阈值%d)", thresholds[i]); 
+         printf("%-18s %10.0f %11.2fx %11.2f%% %11.2f%% %7.2f%% %8ld %12ld %12ld\n", name, r.throughput, 
+                r.throughput / base, r.frag_avg * 100, r.frag_max * 100, r.internal_waste * 100, 
+                r.fails, r.quick_hits, r.consolidations); 
+     } 
+     return 0; 
+ } 
+ 
+ //放置策略对比入口：同一请求序列下，在小堆和大堆上比较四种策略的速度和碎片 
+ int run_fits(int argc, char* argv[]) { 
+     long ops = argc >= 3 ? atol(argv[2]) : 200000; 
+     unsigned int seed = argc >= 4 ? (unsigned int)atoi(argv[3]) : (unsigned int)time(NULL); 
+     static const int scales[] = { Churn_Live_Slots, Churn_Live_Slots * 32 }; 
+     printf("———————————— 放置策略对比 ————————————\n"); 
+     printf("随机种子: %u, 操作数: %ld, 请求大小 %d-%d, 立即合并\n", seed, ops, Churn_Min_R, Churn_Max_R); 
+     for (int s = 0; s < (int)(sizeof(scales) / sizeof(scales[0])); ++s) { 
+         printf("\n同时持有最多 %d 块, arena %d 字节\n", scales[s], scales[s] * Churn_Arena_Per_Slot); 
+         printf("策略                吞吐(ops/s) 平均外部碎片 最大外部碎片 分配失败\n"); 
+         for (int f = FIT_FIRST; f <= FIT_WORST; ++f) { 
+             ChurnResult r = churn_run(ops, 0, (FitPolicy)f, scales[s], seed); 
+             printf("%-20s %10.0f %11.2f%% %11.2f%% %8ld\n", fit_name[f], r.throughput, 
+                    r.frag_avg * 100, r.frag_max * 100, r.fails); 
+         } 
+     } 
+     return 0; 
+ } 
+ 
+ //———————————————————————————— 多种子蒙特卡洛实验 ———————————————————————————— 
+ 
+ //样本累加器，用于均值和95%置信区间 
+ typedef struct McStat { 
+     long n; 
+     double sum; 
+     double sumsq; 
+ } McStat; 
+ 
+ void mc_add(McStat* st, double x) { 
+     st->n++; 
+     st->sum += x; 
+     st->sumsq += x * x; 
+ } 
+ 
+ void mc_merge(McStat* dst, const McStat* src) { 
+     dst->n += src->n; 
+     dst->sum += src->sum; 
+     dst->sumsq += src->sumsq; 
+ } 
+ 
+ double mc_mean(const McStat* st) { 
+     return st->n ? st->sum / st->n : 0.0; 
+ } 
+ 
+ //均值的95%置信区间半宽，1.96 × 样本标准差 / sqrt(n) 
+ double mc_ci95(const McStat* st) { 
+     if (st->n < 2) return 0.0; 
+     double mean = st->sum / st->n; 
+     double var = (st->sumsq - st->n * mean * mean) / (st->n - 1); 
+     return var > 0 ? 1.96 * sqrt(var / st->n) : 0.0; 
+ } 
+ 
+ typedef struct McPolicyStats { 
+     McStat success;//每个种子的分配成功率 
+     McStat frag;//分配阶段结束时的外部碎片率 
+     McStat ops;//每批种子的吞吐(ops/s) 
+ } McPolicyStats; 
+ 
+ typedef struct McSim { 
+     long nseeds; 
+     unsigned int first_seed; 
+     atomic_long next;//下一批的起始下标 
+     pthread_mutex_t lock;//合并结果时使用 
+     McPolicyStats stats[FIT_WORST + 1]; 
+ } McSim; 
+ 
+ //把arena恢复成一个完整的空闲块 
+ void arena_reset(Arena* a) { 
+     arena_clear(a); 
+     a->Block_ID = 0; 
+     a->last_addr = a->baseAddr; 
+     insert_sorted(a, new_block(a, a->baseAddr, a->baseAddr + a->size - 1, true, -1)); 
+ } 
+ 
+ //和演示程序相同的一次实验：n个进程按顺序申请，再按顺序全部回收，返回成功分配数 
+ int mc_trial(Arena* a, const int reqs[], int n, double* frag) { 
+     Block* blk[Total_Procs]; 
+     int ok = 0; 
+     arena_reset(a); 
+     for (int i = 0; i < n; ++i) { 
+         blk[i] = arena_alloc(a, reqs[i], i); 
+         if (blk[i]) ok++; 
+     } 
+     *frag = arena_fragmentation(a); 
+     for (int i = 0; i < n; ++i) { 
+         if (blk[i]) arena_release(a, blk[i]); 
+     } 
+     return ok; 
+ } 
+ 
+ void* mc_worker(void* arg) { 
+     McSim* sim = (McSim*)arg; 
+     McPolicyStats local[FIT_WORST + 1]; 
+     memset(local, 0, sizeof(local)); 
+     Arena arenas[FIT_WORST + 1]; 
+     for (int f = FIT_FIRST; f <= FIT_WORST; ++f) { 
+         arena_init(&arenas[f], f, 0, M_S, 1, false); 
+         arenas[f].fit = f; 
+     } 
+     while (true) { 
+         long start = atomic_fetch_add(&sim->next, MC_Batch); 
+         if (start >= sim->nseeds) break; 
+         long end = start + MC_Batch < sim->nseeds ? start + MC_Batch : sim->nseeds; 
+         for (int f = FIT_FIRST; f <= FIT_WORST; ++f) { 
+             long ops = 0; 
+             double t0 = now_sec(); 
+             for (long k = start; k < end; ++k) { 
+                 unsigned int seed = sim->first_seed + (unsigned int)k; 
+                 unsigned int r = seed * 2654435761u + 1; 
+                 int reqs[Total_Procs]; 
+                 for (int i = 0; i < Total_Procs; ++i) reqs[i] = Min_R + (int)(xorshift32(&r) % (Max_R - Min_R + 1)); 
+                 //同一个种子下四种策略的块起始地址也用相同的随机序列 
+                 arenas[f].rng = r | 1; 
+                 double frag; 
+                 int ok = mc_trial(&arenas[f], reqs, Total_Procs, &frag); 
+                 ops += Total_Procs + ok; 
+                 mc_add(&local[f].success, (double)ok / Total_Procs); 
+                 mc_add(&local[f].frag, frag); 
+             } 
+             double elapsed = now_sec() - t0; 
+             if (elapsed > 0) mc_add(&local[f].ops, ops / elapsed); 
+         } 
+     } 
+     pthread_mutex_lock(&sim->lock); 
+     for (int f = FIT_FIRST; f <= FIT_WORST; ++f) { 
+         mc_merge(&sim->stats[f].success, &local[f].success); 
+         mc_merge(&sim->stats[f].frag, &local[f].frag); 
+         mc_merge(&sim->stats[f].ops, &local[f].ops); 
+     } 
+     pthread_mutex_unlock(&sim->lock); 
+     for (int f = FIT_FIRST; f <= FIT_WORST; ++f) arena_destroy(&arenas[f]); 
+     return NULL; 
+ } 
+ 
+ //蒙特卡洛入口：多线程跑大量种子，按策略汇总成功率、碎片率、吞吐及95%置信区间 
+ int run_mc(int argc, char* argv[]) { 
+     long nseeds = argc >= 3 ? atol(argv[2]) : 10000; 
+     long ncpu = sysconf(_SC_NPROCESSORS_ONLN); 
+     int nthreads = argc >= 4 ? atoi(argv[3]) : (int)(ncpu > 0 ? ncpu : 1); 
+     unsigned int first_seed = argc >= 5 ? (unsigned int)atoi(argv[4]) : 1; 
+     const char* out_path = argc >= 6 ? argv[5] : "mc_summary.csv"; 
+     if (nseeds < 1) nseeds = 1; 
+     if (nthreads < 1) nthreads = 1; 
+     if (nthreads > MT_Max_Threads) nthreads = MT_Max_Threads; 
+     McSim* sim = (McSim*)calloc(1, sizeof(McSim)); 
+     pthread_t* tids = (pthread_t*)malloc(sizeof(pthread_t) * nthreads); 
+     if (!sim || !tids) { perror("malloc"); exit(1); } 
+     sim->nseeds = nseeds; 
+     sim->first_seed = first_seed; 
+     atomic_init(&sim->next, 0); 
+     pthread_mutex_init(&sim->lock, NULL); 
+     printf("———————————— 多种子蒙特卡洛实验 ————————————\n"); 
+     printf("种子 %u..%u 共 %ld 个, 线程数 %d, 每个种子 %d 个进程, 请求 %d-%d, 内存 %d 字节\n\n", 
+            first_seed, first_seed + (unsigned int)(nseeds - 1), nseeds, nthreads, Total_Procs, Min_R, Max_R, M_S); 
+     double t0 = now_sec(); 
+     for (int i = 0; i < nthreads; ++i) { 
+         if (pthread_create(&tids[i], NULL, mc_worker, sim) != 0) { 
+             perror("pthread_create"); 
+             exit(1); 
+         } 
+     } 
+     for (int i = 0; i < nthreads; ++i) pthread_join(tids[i], NULL); 
+     double elapsed = now_sec() - t0; 
+ 
+     FILE* out = fopen(out_path, "w"); 
+     if (!out) perror(out_path); 
+     else fprintf(out, "policy,seeds,success_mean,success_ci95,frag_mean,frag_ci95,ops_per_sec_mean,ops_per_sec_ci95\n"); 
+     printf("策略                成功率(±95%%CI)       外部碎片(±95%%CI)     吞吐ops/s(±95%%CI)\n"); 
+     static const char* fit_tag[] = { "FF", "NF", "BF", "WF" }; 
+     for (int f = FIT_FIRST; f <= FIT_WORST; ++f) { 
+         McPolicyStats* st = &sim->stats[f]; 
+         printf("%-20s %7.2f%% ± %5.2f%%   %7.2f%% ± %5.2f%%   %10.0f ± %8.0f\n", fit_name[f], 
+                mc_mean(&st->success) * 100, mc_ci95(&st->success) * 100, 
+                mc_mean(&st->frag) * 100, mc_ci95(&st->frag) * 100, 
+                mc_mean(&st->ops), mc_ci95(&st->ops)); 
+         if (out) { 
+             fprintf(out, "%s,%ld,%.6f,%.6f,%.6f,%.6f,%.1f,%.1f\n", fit_tag[f], st->success.n, 
+                     mc_mean(&st->success), mc_ci95(&st->success), mc_mean(&st->frag), mc_ci95(&st->frag), 
+                     mc_mean(&st->ops), mc_ci95(&st->ops)); 
+         } 
+     } 
+     if (out) { 
+         fclose(out); 
+         printf("\n汇总表已写入: %s\n", out_path); 
+     } 
+     printf("总耗时 %.2f s\n", elapsed); 
+     pthread_mutex_destroy(&sim->lock); 
+     free(tids); 
+     free(sim); 
+     return 0; 
+ } 
+ 
+ //———————————————————————————— 分配轨迹 ———————————————————————————— 
+ 
+ //轨迹文件每行一条操作："a <对象号> <大小> [调用点]" 表示分配，"f <对象号>" 表示释放，#开头为注释 
+ typedef struct TraceOp { 
+     char op;//'a'或'f' 
+     int id;//对象号 
+     int size; 
+     int hint;//分配调用点编号，没有则为0 
+ } TraceOp; 
+ 
+ typedef struct Trace { 
+     TraceOp* ops; 
+     long n; 
+     long cap; 
+     int max_id; 
+ } Trace; 
+ 
+ void trace_push(Trace* t, char op, int id, int size, int hint) { 
+     if (t->n == t->cap) { 
+         t->cap = t->cap ? t->cap * 2 : 1024; 
+         t->ops = (TraceOp*)realloc(t->ops, sizeof(TraceOp) * t->cap); 
+         if (!t->ops) { perror("realloc"); exit(1); } 
+     } 
+     t->ops[t->n].op = op; 
+     t->ops[t->n].id = id; 
+     t->ops[t->n].size = size; 
+     t->ops[t->n].hint = hint; 
+     t->n++; 
+     if (id > t->max_id) t->max_id = id; 
+ } 
+ 
+ void trace_free(Trace* t) { 
+     free(t->ops); 
+     t->ops = NULL; 
+     t->n = t->cap = 0; 
+     t->max_id = 0; 
+ } 
+ 
+ bool trace_load(const char* path, Trace* t) { 
+     FILE* f = fopen(path, "r"); 
+     if (!f) { perror(path); return false; } 
+     char line[256]; 
+     long lineno = 0; 
+     while (fgets(line, sizeof(line), f)) { 
+         lineno++; 
+         char op; 
+         int id, size = 0, hint = 0; 
+         if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue; 
+         int got = sscanf(line, " %c %d %d %d", &op, &id, &size, &hint); 
+         if (got < 2 || id < 0 || (op == 'a' && (got < 3 || size <= 0)) || (op != 'a' && op != 'f')) { 
+             fprintf(stderr, "%s:%ld: 无法解析的轨迹行\n", path, lineno); 
+             fclose(f); 
+             return false; 
+         } 
+         trace_push(t, op, id, size, hint); 
+     } 
+     fclose(f); 
+     return true; 
+ } 
+ 
+ bool trace_save(const char* path, const Trace* t) { 
+     FILE* f = fopen(path, "w"); 
+     if (!f) { perror(path); return false; } 
+     fprintf(f, "# a <对象号> <大小> <调用点> / f <对象号>\n"); 
+     for (long i = 0; i < t->n; ++i) { 
+         if (t->ops[i].op == 'a') fprintf(f, "a %d %d %d\n", t->ops[i].id, t->ops[i].size, t->ops[i].hint); 
+         else fprintf(f, "f %d\n", t->ops[i].id); 
+     } 
+     fclose(f); 
+     return true; 
+ } 
+ 
+ //合成轨迹：调用点6、7分配长寿命对象，一直活到所在阶段结束（每阶段32×live次操作）， 
+ //调用点0-5分配短寿命对象，各调用点有自己偏好的大小；unit为平均大小 
+ void trace_synthesize(Trace* t, long ops, int live, int unit, unsigned int seed) { 
+     static const int site_size_x8[8] = { 2, 3, 4, 6, 8, 12, 10, 20 };//各调用点的平均大小，单位unit/8 
+     unsigned int r = seed * 2654435761u + 7; 
+     int* short_ids = (int*)malloc(sizeof(int) * live); 
+     int* long_ids = (int*)malloc(sizeof(int) * live); 
+     if (!short_ids || !long_ids) { perror("malloc"); exit(1); } 
+     int nshort = 0, nlong = 0, next_id = 0; 
+     long phase = (long)live * 32;//每个阶段结束时释放该阶段的全部长寿命对象 
+     for (long i = 0; i < ops; ++i) { 
+         if (i % phase == phase - 1) { 
+             while (nlong > 0) trace_push(t, 'f', long_ids[--nlong], 0, 0); 
+         } 
+         int r100 = (int)(xorshift32(&r) % 100); 
+         bool can_alloc = nshort + nlong < live; 
+         if (can_alloc && (nshort == 0 || r100 < 52)) { 
+             //长寿命对象约占分配的1/4，阶段内一直累积，最多占存活对象的一半 
+             int site = (int)(xorshift32(&r) % 8); 
+             if (site >= 6 && nlong >= live / 2) site -= 6; 
+             int avg = unit * site_size_x8[site] / 8; 
+             if (avg < 1) avg = 1; 
+             int size = avg / 2 + (int)(xorshift32(&r) % (unsigned int)(avg + 1)); 
+             if (size < 1) size = 1; 
+             trace_push(t, 'a', next_id, size, site); 
+             if (site >= 6) long_ids[nlong++] = next_id; 
+             else short_ids[nshort++] = next_id; 
+             next_id++; 
+         } 
+         else if (nshort > 0) { 
+             int k = (int)(xorshift32(&r) % (unsigned int)nshort); 
+             trace_push(t, 'f', short_ids[k], 0, 0); 
+             short_ids[k] = short_ids[--nshort]; 
+         } 
+     } 
+     while (nshort > 0) trace_push(t, 'f', short_ids[--nshort], 0, 0); 
+     while (nlong > 0) trace_push(t, 'f', long_ids[--nlong], 0, 0); 
+     free(short_ids); 
+     free(long_ids); 
+ } 
+ 
+ //生成合成轨迹文件的入口 
+ int run_gentrace(int argc, char* argv[]) { 
+     if (argc < 3) { 
+         fprintf(stderr, "用法: %s gentrace <输出文件> [操作数] [最多存活对象数] [平均大小] [种子]\n", argv[0]); 
+         return 1; 
+     } 
+     long ops = argc >= 4 ? atol(argv[3]) : 200000; 
+     int live = argc >= 5 ? atoi(argv[4]) : 1024; 
+     int unit = argc >= 6 ? atoi(argv[5]) : 256; 
+     unsigned int seed = argc >= 7 ? (unsigned int)atoi(argv[6]) : (unsigned int)time(NULL); 
+     if (live < 1) live = 1; 
+     if (unit < 1) unit = 1; 
+     Trace t = { 0 }; 
+     trace_synthesize(&t, ops, live, unit, seed); 
+     bool ok = trace_save(argv[2], &t); 
+     if (ok) printf("已写入 %ld 条操作到 %s（最多存活 %d 个对象, 平均大小约 %d, 种子 %u）\n", t.n, argv[2], live, unit, seed); 
+     trace_free(&t); 
+     return ok ? 0 : 1; 
+ } 
+ 
+ //———————————————————————————— 吞吐与延迟基准测试 ———————————————————————————— 
+ 
+ //硬件缓存未命中计数，只在Linux上通过perf_event读取，打不开（无权限、虚拟机、其他系统）时为-1 
+ typedef struct PerfCounters { 
+     int l1_fd; 
+     int llc_fd; 
+     long long l1_miss; 
+     long long llc_miss; 
+ } PerfCounters; 
+ 
+ int perf_open_cache(unsigned long long cache) { 
+ #ifdef __linux__ 
+     struct perf_event_attr pe; 
+     memset(&pe, 0, sizeof(pe)); 
+     pe.type = PERF_TYPE_HW_CACHE; 
+     pe.size = sizeof(pe); 
+     pe.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16); 
+     pe.disabled = 1; 
+     pe.exclude_kernel = 1; 
+     pe.exclude_hv = 1; 
+     return (int)syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0); 
+ #else 
+     (void)cache; 
+     return -1; 
+ #endif 
+ } 
+ 
+ void perf_begin(PerfCounters* pc) { 
+ #ifdef __linux__ 
+     pc->l1_fd = perf_open_cache(PERF_COUNT_HW_CACHE_L1D); 
+     pc->llc_fd = perf_open_cache(PERF_COUNT_HW_CACHE_LL); 
+     int fds[2] = { pc->l1_fd, pc->llc_fd }; 
+     for (int i = 0; i < 2; ++i) { 
+         if (fds[i] >= 0) { 
+             ioctl(fds[i], PERF_EVENT_IOC_RESET, 0); 
+             ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0); 
+         } 
+     } 
+ #else 
+     pc->l1_fd = pc->llc_fd = -1; 
+ #endif 
+     pc->l1_miss = pc->llc_miss = -1; 
+ } 
+ 
+ void perf_end(PerfCounters* pc) { 
+ #ifdef __linux__ 
+     int fds[2] = { pc->l1_fd, pc->llc_fd }; 
+     long long* out[2] = { &pc->l1_miss, &pc->llc_miss }; 
+     for (int i = 0; i < 2; ++i) { 
+         if (fds[i] < 0) continue; 
+         ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0); 
+         long long v; 
+         if (read(fds[i], &v, sizeof(v)) == (ssize_t)sizeof(v)) *out[i] = v; 
+         close(fds[i]); 
+     } 
+ #else 
+     (void)pc; 
+ #endif 
+ } 
+ 
+ typedef enum { WL_UNIFORM, WL_BIMODAL, WL_TRACE } Workload; 
+ static const char* workload_name[] = { "均匀", "双峰", "轨迹回放" }; 
+ 
+ typedef struct BenchResult { 
+     long allocs; 
+     long frees; 
+     long fails; 
+     long long alloc_p50, alloc_p99, alloc_p999;//ns 
+     long long free_p50, free_p99, free_p999; 
+     long long meta_peak; 
+     double l1_per_op;//-1表示不可用 
+     double llc_per_op; 
+ } BenchResult; 
+ 
+ int cmp_ll(const void* x, const void* y) { 
+     long long a = *(const long long*)x, b = *(const long long*)y; 
+     return a < b ? -1 : a > b; 
+ } 
+ 
+ //排序后取分位数，q为0到1 
+ long long percentile(long long* v, long n, double q) { 
+     if (n == 0) return 0; 
+     return v[(long)(q * (n - 1))]; 
+ } 
+ 
+ //一次空计时的开销，从每个样本中扣除 
+ long long timer_overhead() { 
+     long long best = LLONG_MAX; 
+     for (int i = 0; i < 1000; ++i) { 
+         long long t0 = now_ns(); 
+         long long t1 = now_ns(); 
+         if (t1 - t0 < best) best = t1 - t0; 
+     } 
+     return best; 
+ } 
+ 
+ //在给定堆大小上跑一个工作负载，逐次计时分配和释放 
+ //均匀/双峰负载：存活对象上限live，平均请求unit字节；轨迹负载直接回放trace 
+ BenchResult bench_run(Workload wl, Addr heap, FitPolicy fit, long ops, int live, int unit, const Trace* trace, unsigned int seed) { 
+     Arena a; 
+     arena_init(&a, 0, 0, heap, seed * 2654435761u + 1, false); 
+     a.fit = fit; 
+     long nops = wl == WL_TRACE ? trace->n : ops; 
+     int nslots = wl == WL_TRACE ? trace->max_id + 1 : live; 
+     long long* alloc_ns = (long long*)malloc(sizeof(long long) * (nops + 1)); 
+     long long* free_ns = (long long*)malloc(sizeof(long long) * (nops + 1)); 
+     Block** slots = (Block**)calloc(nslots, sizeof(Block*)); 
+     if (!alloc_ns || !free_ns || !slots) { perror("malloc"); exit(1); } 
+     long long overhead = timer_overhead(); 
+     unsigned int wrng = seed + 0x9e3779b9u; 
+     int live_n = 0; 
+     BenchResult res = { 0 }; 
+     PerfCounters pc; 
+     perf_begin(&pc); 
+     for (long i = 0; i < nops; ++i) { 
+         int req = 0; 
+         int slot; 
+         bool do_alloc; 
+         if (wl == WL_TRACE) { 
+             slot = trace->ops[i].id; 
+             do_alloc = trace->ops[i].op == 'a'; 
+             req = trace->ops[i].size; 
+             if (do_alloc == (slots[slot] != NULL)) continue;//重复分配或释放失败的对象，跳过 
+         } 
+         else { 
+             int r = (int)(xorshift32(&wrng) % 100); 
+             do_alloc = live_n < live && (live_n == 0 || r < 55); 
+             if (do_alloc) { 
+                 slot = live_n; 
+                 if (wl == WL_UNIFORM) { 
+                     req = unit / 2 + (int)(xorshift32(&wrng) % (unsigned int)(unit + 1)); 
+                 } 
+                 else if (xorshift32(&wrng) % 10 != 0) { 
+                     req = unit / 8 + (int)(xorshift32(&wrng) % (unsigned int)(unit / 4 + 1)); 
+                 } 
+                 else { 
+                     req = unit * 6 + (int)(xorshift32(&wrng) % (unsigned int)(unit * 7 / 2 + 1)); 
+                 } 
+                 if (req < 1) req = 1; 
+             } 
+             else { 
+                 slot = (int)(xorshift32(&wrng) % (unsigned int)live_n); 
+             } 
+         } 
+         if (do_alloc) { 
+             long long t0 = now_ns(); 
+             Block* b = arena_alloc(&a, req, 0); 
+             long long t1 = now_ns(); 
+             alloc_ns[res.allocs + res.fails] = t1 - t0 > overhead ? t1 - t0 - overhead : 0; 
+             if (b) { 
+                 slots[slot] = b; 
+                 res.allocs++; 
+                 if (wl != WL_TRACE) live_n++; 
+             } 
+             else { 
+                 res.fails++; 
+             } 
+         } 
+         else { 
+             long long t0 = now_ns(); 
+             arena_release(&a, slots[slot]); 
+             long long t1 = now_ns(); 
+             free_ns[res.frees++] = t1 - t0 > overhead ? t1 - t0 - overhead : 0; 
+             if (wl == WL_TRACE) slots[slot] = NULL; 
+             else slots[slot] = slots[--live_n]; 
+         } 
+     } 
+     perf_end(&pc); 
+     long nalloc = res.allocs + res.fails; 
+     qsort(alloc_ns, nalloc, sizeof(long long), cmp_ll); 
+     qsort(free_ns, res.frees, sizeof(long long), cmp_ll); 
+     res.alloc_p50 = percentile(alloc_ns, nalloc, 0.50); 
+     res.alloc_p99 = percentile(alloc_ns, nalloc, 0.99); 
+     res.alloc_p999 = percentile(alloc_ns, nalloc, 0.999); 
+     res.free_p50 = percentile(free_ns, res.frees, 0.50); 
+     res.free_p99 = percentile(free_ns, res.frees, 0.99); 
+     res.free_p999 = percentile(free_ns, res.frees, 0.999); 
+     res.meta_peak = a.meta_peak; 
+     long total = nalloc + res.frees; 
+     res.l1_per_op = pc.l1_miss >= 0 && total ? (double)pc.l1_miss / total : -1; 
+     res.llc_per_op = pc.llc_miss >= 0 && total ? (double)pc.llc_miss / total : -1; 
+     free(alloc_ns); 
+     free(free_ns); 
+     free(slots); 
+     arena_destroy(&a); 
+     return res; 
+ } 
+ 
+ void format_bytes(Addr n, char* buf, size_t len) { 
+     if (n >= (1LL << 30)) snprintf(buf, len, "%lldGB", n >> 30); 
+     else if (n >= (1LL << 20)) snprintf(buf, len, "%lldMB", n >> 20); 
+     else if (n >= (1LL << 10)) snprintf(buf, len, "%lldKB", n >> 10); 
+     else snprintf(buf, len, "%lldB", n); 
+ } 
+ 
+ //基准测试入口：三种负载 × 1KB到16GB的堆 × 四种放置策略 
+ int run_bench(int argc, char* argv[]) { 
+     long ops = argc >= 3 ? atol(argv[2]) : 100000; 
+     const char* trace_path = argc >= 4 ? argv[3] : NULL; 
+     unsigned int seed = 1; 
+     Trace file_trace = { 0 }; 
+     if (trace_path && !trace_load(trace_path, &file_trace)) return 1; 
+     printf("———————————— 分配器吞吐与延迟基准 ————————————\n"); 
+     printf("每轮操作数: %ld, 轨迹: %s, 延迟已扣除计时开销 %lld ns\n", ops, 
+            trace_path ? trace_path : "合成（按堆大小缩放）", timer_overhead()); 
+     printf("缓存未命中为每次操作的L1D/LLC读未命中数，n/a表示perf_event不可用\n\n"); 
+     printf("%-8s %6s %-18s %22s %22s %7s %10s %8s %8s\n", "负载", "堆", "策略", 
+            "分配ns p50/p99/p99.9", "释放ns p50/p99/p99.9", "失败", "元数据峰值", "L1D/op", "LLC/op"); 
+     for (int w = WL_UNIFORM; w <= WL_TRACE; ++w) { 
+         Addr heap = 1024; 
+         for (int h = 0; h < Bench_Heaps; ++h, heap *= 64) { 
+             int live = heap / 64 < Bench_Max_Live ? (int)(heap / 64) : Bench_Max_Live; 
+             int unit = (int)(heap / (2 * live)); 
+             Trace synth = { 0 }; 
+             const Trace* trace = &file_trace; 
+             if (w == WL_TRACE && !trace_path) { 
+                 trace_synthesize(&synth, ops, live, unit, seed); 
+                 trace = &synth; 
+             } 
+             for (int f = FIT_FIRST; f <= FIT_WORST; ++f) { 
+                 BenchResult r = bench_run((Workload)w, heap, (FitPolicy)f, ops, live, unit, trace, seed); 
+                 char hb[16], mb[16], l1[16], llc[16], an[32], fn[32]; 
+                 format_bytes(heap, hb, sizeof(hb)); 
+                 format_bytes(r.meta_peak, mb, sizeof(mb)); 
+                 snprintf(an, sizeof(an), "%lld/%lld/%lld", r.alloc_p50, r.alloc_p99, r.alloc_p999); 
+                 snprintf(fn, sizeof(fn), "%lld/%lld/%lld", r.free_p50, r.free_p99, r.free_p999); 
+                 if (r.l1_per_op >= 0) snprintf(l1, sizeof(l1), "%.2f", r.l1_per_op); 
+                 else snprintf(l1, sizeof(l1), "n/a"); 
+                 if (r.llc_per_op >= 0) snprintf(llc, sizeof(llc), "%.2f", r.llc_per_op); 
+                 else snprintf(llc, sizeof(llc), "n/a"); 
+                 printf("%-8s %6s %-18s %22s %22s %7ld %10s %8s %8s\n", workload_name[w], hb, fit_name[f], 
+                        an, fn, r.fails, mb, l1, llc); 
+             } 
+             trace_free(&synth); 
+         } 
+     } 
+     trace_free(&file_trace); 
+     return 0; 
+ } 
+ 
+ //———————————————————————————— 按寿命分区 ———————————————————————————— 
+ 
+ //从轨迹离线统计各调用点的寿命（以操作数计），平均寿命明显偏长的调用点判为长寿命 
+ typedef struct LifetimeProfile { 
+     long count[Lifetime_Max_Sites];//各调用点的分配次数 
+     double mean_life[Lifetime_Max_Sites]; 
+     bool long_lived[Lifetime_Max_Sites]; 
+     double overall_mean; 
+     Addr live_peak;//所有对象同时存活的最大字节数 
+ } LifetimeProfile; 
+ 
+ int lifetime_site(int hint) { 
+     return (hint % Lifetime_Max_Sites + Lifetime_Max_Sites) % Lifetime_Max_Sites; 
+ } 
+ 
+ void lifetime_profile(const Trace* t, LifetimeProfile* p) { 
+     memset(p, 0, sizeof(*p)); 
+     long* born = (long*)malloc(sizeof(long) * (t->max_id + 1)); 
+     int* site = (int*)malloc(sizeof(int) * (t->max_id + 1)); 
+     int* size = (int*)malloc(sizeof(int) * (t->max_id + 1)); 
+     if (!born || !site || !size) { perror("malloc"); exit(1); } 
+     for (int i = 0; i <= t->max_id; ++i) born[i] = -1; 
+     double total_life[Lifetime_Max_Sites] = { 0 }; 
+     //第一遍：按调用点累计寿命，到轨迹结束仍存活的对象寿命记到结束为止 
+     for (long i = 0; i < t->n; ++i) { 
+         const TraceOp* op = &t->ops[i]; 
+         if (op->op == 'a') { 
+             born[op->id] = i; 
+             site[op->id] = lifetime_site(op->hint); 
+             size[op->id] = op->size; 
+         } 
+         else if (born[op->id] >= 0) { 
+             total_life[site[op->id]] += i - born[op->id]; 
+             p->count[site[op->id]]++; 
+             born[op->id] = -1; 
+         } 
+     } 
+     for (int i = 0; i <= t->max_id; ++i) { 
+         if (born[i] >= 0) { 
+             total_life[site[i]] += t->n - born[i]; 
+             p->count[site[i]]++; 
+         } 
+     } 
+     long all = 0; 
+     double all_life = 0; 
+     for (int s = 0; s < Lifetime_Max_Sites; ++s) { 
+         if (p->count[s] == 0) continue; 
+         p->mean_life[s] = total_life[s] / p->count[s]; 
+         all += p->count[s]; 
+         all_life += total_life[s]; 
+     } 
+     p->overall_mean = all ? all_life / all : 0; 
+     for (int s = 0; s < Lifetime_Max_Sites; ++s) { 
+         p->long_lived[s] = p->count[s] > 0 && p->mean_life[s] > Lifetime_Long_Factor * p->overall_mean; 
+     } 
+     //第二遍：统计存活字节峰值，用来确定arena大小 
+     Addr live_bytes = 0; 
+     for (int i = 0; i <= t->max_id; ++i) born[i] = -1; 
+     for (long i = 0; i < t->n; ++i) { 
+         const TraceOp* op = &t->ops[i]; 
+         if (op->op == 'a') { 
+             if (born[op->id] >= 0) continue; 
+             born[op->id] = i; 
+             site[op->id] = lifetime_site(op->hint); 
+             size[op->id] = op->size; 
+             live_bytes += op->size; 
+         } 
+         else if (born[op->id] >= 0) { 
+             live_bytes -= size[op->id]; 
+             born[op->id] = -1; 
+         } 
+         if (live_bytes > p->live_peak) p->live_peak = live_bytes; 
+     } 
+     free(born); 
+     free(site); 
+     free(size); 
+ } 
+ 
+ typedef struct ReplayResult { 
+     double throughput;//ops/s，不含采样时间 
+     double frag_avg; 
+     double frag_max; 
+     double steps_per_alloc;//每次分配平均访问的结点数 
+     long fails; 
+     long allocs; 
+ } ReplayResult; 
+ 
+ //在大小为size的arena上回放轨迹，寿命类别取自离线统计 
+ ReplayResult lifetime_replay(const Trace* t, const LifetimeProfile* p, FitPolicy fit, Placement place, Addr size, unsigned int seed) { 
+     Arena a; 
+     arena_init(&a, 0, 0, size, seed * 2654435761u + 1, false); 
+     a.fit = fit; 
+     a.placement = place; 
+     Block** obj = (Block**)calloc(t->max_id + 1, sizeof(Block*)); 
+     if (!obj) { perror("malloc"); exit(1); } 
+     ReplayResult res = { 0 }; 
+     long samples = 0; 
+     double sample_time = 0; 
+     double t0 = now_sec(); 
+     for (long i = 0; i < t->n; ++i) { 
+         const TraceOp* op = &t->ops[i]; 
+         if (op->op == 'a') { 
+             if (!obj[op->id]) { 
+                 obj[op->id] = arena_alloc_hint(&a, op->size, 0, p->long_lived[lifetime_site(op->hint)]); 
+                 if (obj[op->id]) res.allocs++; 
+                 else res.fails++; 
+             } 
+         } 
+         else if (obj[op->id]) { 
+             arena_release(&a, obj[op->id]); 
+             obj[op->id] = NULL; 
+         } 
+         if (i % Churn_Sample_Every == 0) { 
+             double s0 = now_sec(); 
+             double f = arena_fragmentation(&a); 
+             res.frag_avg += f; 
+             if (f > res.frag_max) res.frag_max = f; 
+             samples++; 
+             sample_time += now_sec() - s0; 
+         } 
+     } 
+     double elapsed = now_sec() - t0 - sample_time; 
+     res.throughput = elapsed > 0 ? t->n / elapsed : 0; 
+     res.frag_avg = samples ? res.frag_avg / samples : 0.0; 
+     res.steps_per_alloc = res.allocs + res.fails ? (double)a.search_steps / (res.allocs + res.fails) : 0.0; 
+     free(obj); 
+     arena_destroy(&a); 
+     return res; 
+ } 
+ 
+ //寿命分区实验入口：同一轨迹下比较四种放置策略与寿命分区的碎片和查找长度 
+ //没有给轨迹文件时用合成轨迹，调用点6、7为长寿命 
+ int run_lifetime(int argc, char* argv[]) { 
+     long ops = argc >= 3 ? atol(argv[2]) : 200000; 
+     const char* trace_path = argc >= 4 && strcmp(argv[3], "-") != 0 ? argv[3] : NULL; 
+     unsigned int seed = argc >= 5 ? (unsigned int)atoi(argv[4]) : (unsigned int)time(NULL); 
+     Trace t = { 0 }; 
+     if (trace_path) { 
+         if (!trace_load(trace_path, &t)) return 1; 
+     } 
+     else { 
+         trace_synthesize(&t, ops, Churn_Live_Slots, (Churn_Min_R + Churn_Max_R) / 2, seed); 
+     } 
+     LifetimeProfile p; 
+     lifetime_profile(&t, &p); 
+     //arena取存活峰值的4/3，与合并策略实验的余量相当 
+     Addr size = p.live_peak + p.live_peak / 3; 
+     printf("———————————— 按寿命分区 vs 传统放置策略 ————————————\n"); 
+     printf("轨迹: %s, 操作数: %ld, 随机种子: %u, arena %lld 字节（存活峰值 %lld 的4/3）\n", 
+            trace_path ? trace_path : "合成", t.n, seed, size, p.live_peak); 
+     printf("长寿命调用点（平均寿命超过全体平均 %.0f 次操作的%d倍）:", p.overall_mean, Lifetime_Long_Factor); 
+     int nlong = 0; 
+     for (int s = 0; s < Lifetime_Max_Sites; ++s) { 
+         if (p.long_lived[s]) { printf(" %d(%.0f)", s, p.mean_life[s]); nlong++; } 
+     } 
+     printf("%s\n", nlong ? "" : " 无"); 
+     for (int pl = PLACE_RANDOM; pl <= PLACE_EDGE; ++pl) { 
+         printf("\n块内放置: %s\n", place_name[pl]); 
+         printf("策略                吞吐(ops/s) 平均外部碎片 最大外部碎片 平均查找长度 分配失败\n"); 
+         for (int f = FIT_FIRST; f <= FIT_LIFETIME; ++f) { 
+             ReplayResult r = lifetime_replay(&t, &p, (FitPolicy)f, (Placement)pl, size, seed); 
+             printf("%-20s %10.0f %11.2f%% %11.2f%% %12.1f %8ld\n", fit_name[f], r.throughput, 
+                    r.frag_avg * 100, r.frag_max * 100, r.steps_per_alloc, r.fails); 
+         } 
+     } 
+     trace_free(&t); 
+     return 0; 
+ } 
+ 
+ //———————————————————————————— 按负载生成尺寸类 ———————————————————————————— 
+ 
+ //轨迹中不超过max_size的分配按align向上对齐后的大小分布，sizes升序 
+ typedef struct SizeHist { 
+     int* sizes; 
+     long* counts; 
+     int n; 
+     long total;//参与统计的分配次数 
+     long skipped;//超过max_size、不归尺寸类管的分配次数 
+ } SizeHist; 
+ 
+ int align_up(int x, int align) { 
+     return (x + align - 1) / align * align; 
+ } 
+ 
+ //统计大小分布；不同大小少于k个时补上没出现过的对齐大小，保证能切出k个尺寸类 
+ //max_size总是作为候选，保证最大的尺寸类能放下所有小对象 
+ void size_histogram(const Trace* t, int align, int max_size, int k, SizeHist* h) { 
+     int slots = max_size / align; 
+     long* cnt = (long*)calloc(slots + 1, sizeof(long)); 
+     if (!cnt) { perror("calloc"); exit(1); } 
+     memset(h, 0, sizeof(*h)); 
+     for (long i = 0; i < t->n; ++i) { 
+         if (t->ops[i].op != 'a') continue; 
+         int sz = align_up(t->ops[i].size, align); 
+         if (sz > max_size) { h->skipped++; continue; } 
+         cnt[sz / align]++; 
+         h->total++; 
+     } 
+     int distinct = 0; 
+     for (int i = 1; i <= slots; ++i) distinct += cnt[i] > 0; 
+     int pad = distinct + (cnt[slots] == 0) < k ? k - distinct - (cnt[slots] == 0) : 0; 
+     h->sizes = (int*)malloc(sizeof(int) * (slots + 1)); 
+     h->counts = (long*)malloc(sizeof(long) * (slots + 1)); 
+     if (!h->sizes || !h->counts) { perror("malloc"); exit(1); } 
+     for (int i = 1; i <= slots; ++i) { 
+         bool keep = cnt[i] > 0 || i == slots; 
+         if (!keep && pad > 0) { keep = true; pad--; } 
+         if (keep) { 
+             h->sizes[h->n] = i * align; 
+             h->counts[h->n] = cnt[i]; 
+             h->n++; 
+         } 
+     } 
+     free(cnt); 
+ } 
+ 
+ void size_hist_free(SizeHist* h) { 
+     free(h->sizes); 
+     free(h->counts); 
+     h->sizes = NULL; 
+     h->counts = NULL; 
+ } 
+ 
+ //给定尺寸类上界（升序，最后一个不小于所有大小），计算内部碎片字节数 
+ long long class_waste(const SizeHist* h, const int* bounds, int k) { 
+     long long waste = 0; 
+     int c = 0; 
+     for (int i = 0; i < h->n; ++i) { 
+         while (c < k && bounds[c] < h->sizes[i]) c++; 
+         if (c == k) return -1; 
+         waste += (long long)h->counts[i] * (bounds[c] - h->sizes[i]); 
+     } 
+     return waste; 
+ } 
+ 
+ //动态规划求k个尺寸类的最优上界，使内部碎片最小，O(k·n²) 
+ //按升序把不同大小分成k段，每段的上界取段内最大的大小； 
+ //best[j][i]为前i+1个大小分成j+1段的最小浪费，前缀和让每段的浪费O(1)算出 
+ int optimal_classes(const SizeHist* h, int k, int* bounds) { 
+     int n = h->n; 
+     if (k > n) k = n; 
+     long long* cnt = (long long*)malloc(sizeof(long long) * (n + 1)); 
+     long long* sum = (long long*)malloc(sizeof(long long) * (n + 1)); 
+     long long* best = (long long*)malloc(sizeof(long long) * k * n); 
+     int* from = (int*)malloc(sizeof(int) * k * n); 
+     if (!cnt || !sum || !best || !from) { perror("malloc"); exit(1); } 
+     cnt[0] = sum[0] = 0; 
+     for (int i = 0; i < n; ++i) { 
+         cnt[i + 1] = cnt[i] + h->counts[i]; 
+         sum[i + 1] = sum[i] + (long long)h->counts[i] * h->sizes[i]; 
+     } 
+     //大小lo..hi合成一个尺寸类的浪费 
+     #define SEG_COST(lo, hi) ((long long)h->sizes[hi] * (cnt[(hi) + 1] - cnt[lo]) - (sum[(hi) + 1] - sum[lo])) 
+     for (int i = 0; i < n; ++i) { 
+         best[i] = SEG_COST(0, i); 
+         from[i] = 0; 
+     } 
+     for (int j = 1; j < k; ++j) { 
+         for (int i = 0; i < n; ++i) { 
+             long long b = LLONG_MAX; 
+             int arg = -1; 
+             for (int lo = j; lo <= i; ++lo) { 
+                 long long v = best[(j - 1) * n + lo - 1] + SEG_COST(lo, i); 
+                 if (v < b) { b = v; arg = lo; } 
+             } 
+             best[j * n + i] = b; 
+             from[j * n + i] = arg; 
+         } 
+     } 
+     #undef SEG_COST 
+     for (int j = k - 1, i = n - 1; j >= 0; --j) { 
+         bounds[j] = h->sizes[i]; 
+         i = from[j * n + i] - 1; 
+     } 
+     free(cnt); 
+     free(sum); 
+     free(best); 
+     free(from); 
+     return k; 
+ } 
+ 
+ //写出可以直接编译进小对象模式的尺寸类表 
+ bool write_class_header(const char* path, const char* source, const int* bounds, int k, long long waste, long long bytes) { 
+     FILE* f = fopen(path, "w"); 
+     if (!f) { perror(path); return false; } 
+     fprintf(f, "//由 classes 子命令根据 %s 生成，内部碎片 %.2f%%\n", source, bytes ? 100.0 * waste / bytes : 0.0); 
+     fprintf(f, "//编译时加 -DSLAB_CLASS_HEADER='\"%s\"' 使用\n", path); 
+     fprintf(f, "#define Slab_Generated_Classes %d\n", k); 
+     fprintf(f, "static const int slab_class_size[Slab_Generated_Classes] = {"); 
+     for (int c = 0; c < k; ++c) fprintf(f, "%s %d", c ? "," : "", bounds[c]); 
+     fprintf(f, " };\n"); 
+     fclose(f); 
+     return true; 
+ } 
+ 
+ //尺寸类分析入口：读轨迹（"-"为合成轨迹），输出大小分布、当前尺寸类与最优尺寸类的内部碎片，可写出头文件 
+ int run_classes(int argc, char* argv[]) { 
+     if (argc < 3) { 
+         fprintf(stderr, "用法: %s classes <轨迹文件|-> [尺寸类数] [最大尺寸] [对齐] [输出头文件]\n", argv[0]); 
+         return 1; 
+     } 
+     int k = argc >= 4 ? atoi(argv[3]) : Slab_Classes; 
+     int max_size = argc >= 5 ? atoi(argv[4]) : Slab_Max_R; 
+     int align = argc >= 6 ? atoi(argv[5]) : 8; 
+     const char* out = argc >= 7 ? argv[6] : NULL; 
+     const char* source = strcmp(argv[2], "-") == 0 ? "合成轨迹（种子1）" : argv[2]; 
+     if (align < 1) align = 1; 
+     max_size = align_up(max_size < 1 ? 1 : max_size, align); 
+     if (k < 1) k = 1; 
+     Trace t = { 0 }; 
+     if (strcmp(argv[2], "-") == 0) { 
+         trace_synthesize(&t, 200000, 1024, Slab_Max_R / 4, 1); 
+     } 
+     else if (!trace_load(argv[2], &t)) { 
+         return 1; 
+     } 
+     SizeHist h; 
+     size_histogram(&t, align, max_size, k, &h); 
+     trace_free(&t); 
+     if (h.total == 0) { 
+         fprintf(stderr, "轨迹中没有不超过 %d 字节的分配\n", max_size); 
+         size_hist_free(&h); 
+         return 1; 
+     } 
+     long long bytes = 0; 
+     for (int i = 0; i < h.n; ++i) bytes += (long long)h.counts[i] * h.sizes[i]; 
+     printf("———————————— 按负载生成尺寸类 ————————————\n"); 
+     printf("轨迹: %s, 不超过 %d 字节的分配 %ld 次（另有 %ld 次更大的分配不归尺寸类管），按 %d 字节对齐后 %d 种大小\n", 
+            source, max_size, h.total, h.skipped, align, h.n); 
+     //出现最多的几种大小，看分布有多偏 
+     int top[8]; 
+     int ntop = 0; 
+     for (int r = 0; r < 8 && r < h.n; ++r) { 
+         int arg = -1; 
+         for (int i = 0; i < h.n; ++i) { 
+             bool used = false; 
+             for (int q = 0; q < ntop; ++q) used |= top[q] == i; 
+             if (!used && h.counts[i] > 0 && (arg < 0 || h.counts[i] > h.counts[arg])) arg = i; 
+         } 
+         if (arg < 0) break; 
+         top[ntop++] = arg; 
+     } 
+     printf("最常见的大小:"); 
+     long covered = 0; 
+     for (int q = 0; q < ntop; ++q) { 
+         printf(" %d(%.1f%%)", h.sizes[top[q]], 100.0 * h.counts[top[q]] / h.total); 
+         covered += h.counts[top[q]]; 
+     } 
+     printf("，合计 %.1f%%\n\n", 100.0 * covered / h.total); 
+ 
+     int* bounds = (int*)malloc(sizeof(int) * k); 
+     if (!bounds) { perror("malloc"); exit(1); } 
+     int nk = optimal_classes(&h, k, bounds); 
+     long long waste = class_waste(&h, bounds, nk); 
+     printf("尺寸类  上界  分配次数  内部碎片(字节)\n"); 
+     for (int c = 0, i = 0; c < nk; ++c) { 
+         long n = 0; 
+         long long w = 0; 
+         for (; i < h.n && h.sizes[i] <= bounds[c]; ++i) { 
+             n += h.counts[i]; 
+             w += (long long)h.counts[i] * (bounds[c] - h.sizes[i]); 
+         } 
+         printf("%6d %5d %9ld %14lld\n", c, bounds[c], n, w); 
+     } 
+     printf("\n最优 %d 个尺寸类: 内部碎片 %.2f%%（%lld / %lld 字节）\n", nk, 100.0 * waste / (bytes + waste), waste, bytes + waste); 
+     long long cur = class_waste(&h, slab_class_size, Slab_Classes); 
+     if (cur >= 0) printf("当前 %d 个尺寸类: 内部碎片 %.2f%%\n", Slab_Classes, 100.0 * cur / (bytes + cur)); 
+     else printf("当前尺寸类最大为 %d，放不下所有不超过 %d 字节的分配\n", slab_class_size[Slab_Classes - 1], max_size); 
+     bool ok = true; 
+     //头文件的表长必须等于Slab_Classes（见SLAB_CLASS_HEADER处的_Static_assert）；k取别的值，或者不同大小不够k种时尺寸类少于k，都不写出头文件 
+     if (out && nk != Slab_Classes) { 
+         fprintf(stderr, "得到 %d 个尺寸类，与小对象模式的 %d 个（Slab_Classes）不符，不写出 %s\n", nk, Slab_Classes, out); 
+         ok = false; 
+     } 
+     else if (out) { 
+         ok = write_class_header(out, source, bounds, nk, waste, bytes + waste); 
+         if (ok) printf("已写入 %s\n", out); 
+     } 
+     free(bounds); 
+     size_hist_free(&h); 
+     return ok ? 0 : 1; 
+ } 
+ 
+ //———————————————————————————— 分页与分配联合模拟 ———————————————————————————— 
+ 
+ //页框与lru_page_replacement.c中的PageFrame对应，页面多时用页表代替逐个比较， 
+ //LRU用按访问时间排序的双向链表代替找最小last_access，两者淘汰顺序相同 
+ typedef enum { REPLACE_LRU, REPLACE_CLOCK } Replacement; 
+ 
+ typedef struct PageFrame { 
+     long page_num;//页面号，-1表示空闲 
+     int prev;//LRU链表中更近访问的页框，-1表示没有 
+     int next;//LRU链表中更早访问的页框 
+     bool referenced;//CLOCK的访问位 
+ } PageFrame; 
+ 
+ typedef struct PageCache { 
+     Replacement policy; 
+     int nframes; 
+     int used;//已装入页面的页框数 
+     PageFrame* frames; 
+     int* where;//页表：页面号 -> 页框下标，-1表示不在内存中 
+     long npages; 
+     int lru_head;//最近访问的页框 
+     int lru_tail;//最久未访问的页框，LRU淘汰它 
+     int hand;//CLOCK指针 
+     long hits; 
+     long misses; 
+ } PageCache; 
+ 
+ void page_cache_init(PageCache* pc, Replacement policy, int nframes, long npages) { 
+     memset(pc, 0, sizeof(*pc)); 
+     pc->policy = policy; 
+     pc->nframes = nframes; 
+     pc->npages = npages; 
+     pc->frames = (PageFrame*)malloc(sizeof(PageFrame) * nframes); 
+     pc->where = (int*)malloc(sizeof(int) * npages); 
+     if (!pc->frames || !pc->where) { perror("malloc"); exit(1); } 
+     for (int i = 0; i < nframes; ++i) { 
+         pc->frames[i].page_num = -1; 
+         pc->frames[i].prev = pc->frames[i].next = -1; 
+         pc->frames[i].referenced = false; 
+     } 
+     for (long i = 0; i < npages; ++i) pc->where[i] = -1; 
+     pc->lru_head = pc->lru_tail = -1; 
+ } 
+ 
+ void page_cache_free(PageCache* pc) { 
+     free(pc->frames); 
+     free(pc->where); 
+ } 
+ 
+ void lru_unlink(PageCache* pc, int f) { 
+     PageFrame* x = &pc->frames[f]; 
+     if (x->prev >= 0) pc->frames[x->prev].next = x->next; 
+     else pc->lru_head = x->next; 
+     if (x->next >= 0) pc->frames[x->next].prev = x->prev; 
+     else pc->lru_tail = x->prev; 
+     x->prev = x->next = -1; 
+ } 
+ 
+ void lru_push_front(PageCache* pc, int f) { 
+     pc->frames[f].prev = -1; 
+     pc->frames[f].next = pc->lru_head; 
+     if (pc->lru_head >= 0) pc->frames[pc->lru_head].prev = f; 
+     pc->lru_head = f; 
+     if (pc->lru_tail < 0) pc->lru_tail = f; 
+ } 
+ 
+ //选出要换出的页框：LRU取最久未访问的；CLOCK转动指针，跳过并清除访问位为1的页框 
+ int page_cache_victim(PageCache* pc) { 
+     if (pc->policy == REPLACE_LRU) return pc->lru_tail; 
+     while (pc->frames[pc->hand].referenced) { 
+         pc->frames[pc->hand].referenced = false; 
+         pc->hand = (pc->hand + 1) % pc->nframes; 
+     } 
+     int f = pc->hand; 
+     pc->hand = (pc->hand + 1) % pc->nframes; 
+     return f; 
+ } 
+ 
+ //访问一个页面，返回是否命中 
+ bool page_cache_access(PageCache* pc, long page) { 
+     int f = pc->where[page]; 
+     if (f >= 0) { 
+         pc->hits++; 
+         if (pc->policy == REPLACE_LRU) { 
+             lru_unlink(pc, f); 
+             lru_push_front(pc, f); 
+         } 
+         else { 
+             pc->frames[f].referenced = true; 
+         } 
+         return true; 
+     } 
+     pc->misses++; 
+     if (pc->used < pc->nframes) { 
+         f = pc->used++; 
+     } 
+     else { 
+         f = page_cache_victim(pc); 
+         pc->where[pc->frames[f].page_num] = -1; 
+         if (pc->policy == REPLACE_LRU) lru_unlink(pc, f); 
+     } 
+     pc->frames[f].page_num = page; 
+     pc->frames[f].referenced = true; 
+     pc->where[page] = f; 
+     if (pc->policy == REPLACE_LRU) lru_push_front(pc, f); 
+     return false; 
+ } 
+ 
+ typedef struct PagingResult { 
+     long accesses;//页面访问次数 
+     long faults[2];//按Replacement下标，LRU与CLOCK的缺页次数 
+     long pages_touched;//至少访问过一次的页面数 
+     double pages_per_access_set;//热点集合平均跨越的页面数 
+     long fails; 
+ } PagingResult; 
+ 
+ //回放轨迹：分配时逐页写一遍新对象，每条操作之后按热点偏好访问Paging_Touches_Per_Op次存活对象， 
+ //每次访问对象内随机一个字节所在的页。随机数序列相同，但存活对象集合（分配失败的对象不在其中）和块大小 
+ //因策略而异，所以各策略访问的对象和对象内偏移并不完全相同，只是统计上可比 
+ PagingResult paging_replay(const Trace* t, const LifetimeProfile* p, FitPolicy fit, Placement place, Addr size, 
+                            int page_size, int nframes, unsigned int seed) { 
+     Arena a; 
+     arena_init(&a, 0, 0, size, seed * 2654435761u + 1, false); 
+     a.fit = fit; 
+     a.placement = place; 
+     long npages = (long)((size + page_size - 1) / page_size); 
+     PageCache pc[2]; 
+     page_cache_init(&pc[REPLACE_LRU], REPLACE_LRU, nframes, npages); 
+     page_cache_init(&pc[REPLACE_CLOCK], REPLACE_CLOCK, nframes, npages); 
+     bool* touched = (bool*)calloc(npages, sizeof(bool)); 
+     Block** obj = (Block**)calloc(t->max_id + 1, sizeof(Block*)); 
+     int* live = (int*)malloc(sizeof(int) * (t->max_id + 1)); 
+     int* pos = (int*)malloc(sizeof(int) * (t->max_id + 1));//对象在live中的下标 
+     if (!touched || !obj || !live || !pos) { perror("malloc"); exit(1); } 
+     int live_n = 0; 
+     int hot[Paging_Hot_Objects];//最近分配的对象号，环形缓冲 
+     int hot_n = 0; 
+     unsigned int arng = seed + 0x7f4a7c15u;//访问序列自己的随机数 
+     PagingResult res = { 0 }; 
+     double hot_pages = 0; 
+     long hot_samples = 0; 
+     for (long i = 0; i < t->n; ++i) { 
+         const TraceOp* op = &t->ops[i]; 
+         if (op->op == 'a') { 
+             if (obj[op->id]) continue; 
+             Block* b = arena_alloc_hint(&a, op->size, 0, p->long_lived[lifetime_site(op->hint)]); 
+             if (!b) { res.fails++; continue; } 
+             obj[op->id] = b; 
+             pos[op->id] = live_n; 
+             live[live_n++] = op->id; 
+             hot[hot_n++ % Paging_Hot_Objects] = op->id; 
+             for (long pg = b->startAddr / page_size; pg <= b->endAddr / page_size; ++pg) { 
+                 for (int r = REPLACE_LRU; r <= REPLACE_CLOCK; ++r) page_cache_access(&pc[r], pg); 
+                 touched[pg] = true; 
+                 res.accesses++; 
+             } 
+         } 
+         else if (obj[op->id]) { 
+             arena_release(&a, obj[op->id]); 
+             obj[op->id] = NULL; 
+             int k = pos[op->id]; 
+             live[k] = live[--live_n]; 
+             pos[live[k]] = k; 
+         } 
+         if (live_n == 0) continue; 
+         for (int j = 0; j < Paging_Touches_Per_Op; ++j) { 
+             int id = -1; 
+             if ((int)(xorshift32(&arng) % 100) < Paging_Hot_Pct && hot_n > 0) { 
+                 int n = hot_n < Paging_Hot_Objects ? hot_n : Paging_Hot_Objects; 
+                 id = hot[xorshift32(&arng) % (unsigned int)n]; 
+             } 
+             if (id < 0 || !obj[id]) id = live[xorshift32(&arng) % (unsigned int)live_n]; 
+             Block* b = obj[id]; 
+             Addr off = (Addr)(xorshift32(&arng) % (unsigned int)(b->endAddr - b->startAddr + 1)); 
+             long pg = (long)((b->startAddr + off) / page_size); 
+             for (int r = REPLACE_LRU; r <= REPLACE_CLOCK; ++r) page_cache_access(&pc[r], pg); 
+             touched[pg] = true; 
+             res.accesses++; 
+         } 
+         //采样热点集合跨越多少个不同的页面，衡量放置的局部性 
+         if (i % Churn_Sample_Every == 0 && hot_n >= Paging_Hot_Objects) { 
+             long pages[Paging_Hot_Objects * 4]; 
+             int np = 0; 
+             for (int h = 0; h < Paging_Hot_Objects; ++h) { 
+                 if (!obj[hot[h]]) continue; 
+                 for (long pg = obj[hot[h]]->startAddr / page_size; pg <= obj[hot[h]]->endAddr / page_size && np < Paging_Hot_Objects * 4; ++pg) { 
+                     bool seen = false; 
+                     for (int q = 0; q < np && !seen; ++q) seen = pages[q] == pg; 
+                     if (!seen) pages[np++] = pg; 
+                 } 
+             } 
+             hot_pages += np; 
+             hot_samples++; 
+         } 
+     } 
+     for (long pg = 0; pg < npages; ++pg) res.pages_touched += touched[pg]; 
+     res.pages_per_access_set = hot_samples ? hot_pages / hot_samples : 0; 
+     res.faults[REPLACE_LRU] = pc[REPLACE_LRU].misses; 
+     res.faults[REPLACE_CLOCK] = pc[REPLACE_CLOCK].misses; 
+     page_cache_free(&pc[REPLACE_LRU]); 
+     page_cache_free(&pc[REPLACE_CLOCK]); 
+     free(touched); 
+     free(obj); 
+     free(live); 
+     free(pos); 
+     arena_destroy(&a); 
+     return res; 
+ } 
+ 
+ //联合模拟入口：同一轨迹和对象访问序列下，比较各放置策略在LRU和CLOCK下的缺页率 
+ int run_paging(int argc, char* argv[]) { 
+     const char* trace_path = argc >= 3 && strcmp(argv[2], "-") != 0 ? argv[2] : NULL; 
+     int page_size = argc >= 4 ? atoi(argv[3]) : Paging_Page_Size; 
+     int nframes = argc >= 5 ? atoi(argv[4]) : 0; 
+     unsigned int seed = argc >= 6 ? (unsigned int)atoi(argv[5]) : (unsigned int)time(NULL); 
+     if (page_size < 1) page_size = Paging_Page_Size; 
+     Trace t = { 0 }; 
+     if (trace_path) { 
+         if (!trace_load(trace_path, &t)) return 1; 
+     } 
+     else { 
+         trace_synthesize(&t, 200000, Churn_Live_Slots, (Churn_Min_R + Churn_Max_R) / 2, seed); 
+     } 
+     LifetimeProfile p; 
+     lifetime_profile(&t, &p); 
+     Addr size = p.live_peak + p.live_peak / 3; 
+     long npages = (long)((size + page_size - 1) / page_size); 
+     if (nframes <= 0) nframes = (int)(npages / 4);//默认内存只装得下四分之一的页面 
+     if (nframes < 1) nframes = 1; 
+     if (nframes > npages) nframes = (int)npages; 
+     printf("———————————— 分页与分配联合模拟 ————————————\n"); 
+     printf("轨迹: %s, 操作数: %ld, 随机种子: %u, arena %lld 字节 = %ld 页 × %d 字节, 物理页框 %d\n", 
+            trace_path ? trace_path : "合成", t.n, seed, size, npages, page_size, nframes); 
+     printf("每条操作后访问存活对象 %d 次，其中 %d%% 落在最近分配的 %d 个对象上\n", 
+            Paging_Touches_Per_Op, Paging_Hot_Pct, Paging_Hot_Objects); 
+     for (int pl = PLACE_RANDOM; pl <= PLACE_EDGE; ++pl) { 
+         printf("\n块内放置: %s\n", place_name[pl]); 
+         printf("策略                LRU缺页率 CLOCK缺页率 热点集合页数 访问过的页面 分配失败\n"); 
+         for (int f = FIT_FIRST; f <= FIT_LIFETIME; ++f) { 
+             PagingResult r = paging_replay(&t, &p, (FitPolicy)f, (Placement)pl, size, page_size, nframes, seed); 
+             printf("%-20s %8.2f%% %10.2f%% %12.1f %12ld %8ld\n", fit_name[f], 
+                    r.accesses ? 100.0 * r.faults[REPLACE_LRU] / r.accesses : 0.0, 
+                    r.accesses ? 100.0 * r.faults[REPLACE_CLOCK] / r.accesses : 0.0, 
+                    r.pages_per_access_set, r.pages_touched, r.fails); 
+         } 
+     } 
+     trace_free(&t); 
+     return 0; 
+ } 
+ 
+ //———————————————————————————— 大区域管理器：区间树 ———————————————————————————— 
+ 
+ //管理TB级地址空间里数量不多的大区域。已用和空闲的区段都放在按起始地址排序的树堆（treap）里， 
+ //每个结点记录子树中最大的空闲长度，首次适应和最坏适应沿树下降即可，O(log n)； 
+ //空闲区段同时挂在按(长度, 起始地址)排序的第二棵树堆上，最佳适应在它上面求下界，也是O(log n)。 
+ //两棵树共用同一批结点，只是各有一套左右指针 
+ typedef struct Extent { 
+     Addr start; 
+     Addr len; 
+     bool free; 
+     unsigned int prio;//树堆优先级，大的在上 
+     struct Extent* l;//地址树 
+     struct Extent* r; 
+     Addr max_free;//地址树子树中最大的空闲长度 
+     struct Extent* sl;//尺寸树，只有空闲区段在上面 
+     struct Extent* sr; 
+ } Extent; 
+ 
+ typedef struct RegionMap { 
+     Addr base; 
+     Addr size; 
+     Extent* root;//地址树 
+     Extent* size_root;//尺寸树 
+     unsigned int rng; 
+     long extents;//区段数 
+     long steps;//查找时访问的结点数 
+ } RegionMap; 
+ 
+ void extent_pull(Extent* x) { 
+     Addr m = x->free ? x->len : 0; 
+     if (x->l && x->l->max_free > m) m = x->l->max_free; 
+     if (x->r && x->r->max_free > m) m = x->r->max_free; 
+     x->max_free = m; 
+ } 
+ 
+ //把地址树t按起始地址拆成 < key 和 >= key 两棵 
+ void addr_split(Extent* t, Addr key, Extent** lo, Extent** hi) { 
+     if (!t) { *lo = *hi = NULL; return; } 
+     if (t->start < key) { 
+         addr_split(t->r, key, &t->r, hi); 
+         *lo = t; 
+     } 
+     else { 
+         addr_split(t->l, key, lo, &t->l); 
+         *hi = t; 
+     } 
+     extent_pull(t); 
+ } 
+ 
+ //合并两棵地址树，要求lo中的地址都小于hi 
+ Extent* addr_merge(Extent* lo, Extent* hi) { 
+     if (!lo) return hi; 
+     if (!hi) return lo; 
+     if (lo->prio > hi->prio) { 
+         lo->r = addr_merge(lo->r, hi); 
+         extent_pull(lo); 
+         return lo; 
+     } 
+     hi->l = addr_merge(lo, hi->l); 
+     extent_pull(hi); 
+     return hi; 
+ } 
+ 
+ void addr_insert(RegionMap* m, Extent* x) { 
+     Extent *lo, *hi; 
+     x->l = x->r = NULL; 
+     extent_pull(x); 
+     addr_split(m->root, x->start, &lo, &hi); 
+     m->root = addr_merge(addr_merge(lo, x), hi); 
+ } 
+ 
+ void addr_erase(RegionMap* m, Extent* x) { 
+     Extent *lo, *mid, *hi; 
+     addr_split(m->root, x->start, &lo, &mid); 
+     addr_split(mid, x->start + 1, &mid, &hi); 
+     m->root = addr_merge(lo, hi); 
+ } 
+ 
+ //尺寸树的键是(长度, 起始地址) 
+ bool size_less(const Extent* a, Addr len, Addr start) { 
+     return a->len < len || (a->len == len && a->start < start); 
+ } 
+ 
+ void size_split(Extent* t, Addr len, Addr start, Extent** lo, Extent** hi) { 
+     if (!t) { *lo = *hi = NULL; return; } 
+     if (size_less(t, len, start)) { 
+         size_split(t->sr, len, start, &t->sr, hi); 
+         *lo = t; 
+     } 
+     else { 
+         size_split(t->sl, len, start, lo, &t->sl); 
+         *hi = t; 
+     } 
+ } 
+ 
+ Extent* size_merge(Extent* lo, Extent* hi) { 
+     if (!lo) return hi; 
+     if (!hi) return lo; 
+     if ((lo->prio ^ 0x5bd1e995u) > (hi->prio ^ 0x5bd1e995u)) { 
+         lo->sr = size_merge(lo->sr, hi); 
+         return lo; 
+     } 
+     hi->sl = size_merge(lo, hi->sl); 
+     return hi; 
+ } 
+ 
+ void size_insert(RegionMap* m, Extent* x) { 
+     Extent *lo, *hi; 
+     x->sl = x->sr = NULL; 
+     size_split(m->size_root, x->len, x->start, &lo, &hi); 
+     m->size_root = size_merge(size_merge(lo, x), hi); 
+ } 
+ 
+ void size_erase(RegionMap* m, Extent* x) { 
+     Extent *lo, *mid, *hi; 
+     size_split(m->size_root, x->len, x->start, &lo, &mid); 
+     size_split(mid, x->len, x->start + 1, &mid, &hi); 
+     m->size_root = size_merge(lo, hi); 
+ } 
+ 
+ Extent* extent_new(RegionMap* m, Addr start, Addr len, bool free) { 
+     Extent* x = (Extent*)calloc(1, sizeof(Extent)); 
+     if (!x) { perror("calloc"); exit(1); } 
+     x->start = start; 
+     x->len = len; 
+     x->free = free; 
+     x->prio = xorshift32(&m->rng); 
+     m->extents++; 
+     return x; 
+ } 
+ 
+ //把区段放进树里，空闲的同时进尺寸树 
+ void extent_link(RegionMap* m, Extent* x) { 
+     addr_insert(m, x); 
+     if (x->free) size_insert(m, x); 
+ } 
+ 
+ void extent_unlink(RegionMap* m, Extent* x) { 
+     addr_erase(m, x); 
+     if (x->free) size_erase(m, x); 
+ } 
+ 
+ void extent_delete(RegionMap* m, Extent* x) { 
+     free(x); 
+     m->extents--; 
+ } 
+ 
+ void region_init(RegionMap* m, Addr base, Addr size, unsigned int seed) { 
+     memset(m, 0, sizeof(*m)); 
+     m->base = base; 
+     m->size = size; 
+     m->rng = seed ? seed : 1; 
+     extent_link(m, extent_new(m, base, size, true)); 
+ } 
+ 
+ void extent_destroy(Extent* t) { 
+     if (!t) return; 
+     extent_destroy(t->l); 
+     extent_destroy(t->r); 
+     free(t); 
+ } 
+ 
+ void region_destroy(RegionMap* m) { 
+     extent_destroy(m->root); 
+     m->root = m->size_root = NULL; 
+     m->extents = 0; 
+ } 
+ 
+ //包含地址addr的区段 
+ Extent* region_find(RegionMap* m, Addr addr) { 
+     Extent* t = m->root; 
+     while (t) { 
+         m->steps++; 
+         if (addr < t->start) t = t->l; 
+         else if (addr >= t->start + t->len) t = t->r; 
+         else return t; 
+     } 
+     return NULL; 
+ } 
+ 
+ //首次适应：最靠前的长度不小于need的空闲区段，左子树能放下就往左走 
+ Extent* region_first_fit(RegionMap* m, Addr need) { 
+     Extent* t = m->root; 
+     if (!t || t->max_free < need) return NULL; 
+     while (t) { 
+         m->steps++; 
+         if (t->l && t->l->max_free >= need) t = t->l; 
+         else if (t->free && t->len >= need) return t; 
+         else t = t->r; 
+     } 
+     return NULL; 
+ } 
+ 
+ //最坏适应：根结点记录的就是全局最大空闲长度，再用首次适应找到最靠前的那一段 
+ Extent* region_worst_fit(RegionMap* m, Addr need) { 
+     if (!m->root || m->root->max_free < need) return NULL; 
+     return region_first_fit(m, m->root->max_free); 
+ } 
+ 
+ //最佳适应：尺寸树上第一个不小于(need, 最小地址)的区段 
+ Extent* region_best_fit(RegionMap* m, Addr need) { 
+     Extent* t = m->size_root; 
+     Extent* best = NULL; 
+     while (t) { 
+         m->steps++; 
+         if (t->len >= need) { 
+             best = t; 
+             t = t->sl; 
+         } 
+         else { 
+             t = t->sr; 
+         } 
+     } 
+     return best; 
+ } 
+ 
+ //在空闲区段x中切出[start, start + len)作为已用区段，两边剩下的仍是空闲区段 
+ Addr region_carve(RegionMap* m, Extent* x, Addr start, Addr len) { 
+     extent_unlink(m, x); 
+     if (x->start < start) extent_link(m, extent_new(m, x->start, start - x->start, true)); 
+     if (start + len < x->start + x->len) extent_link(m, extent_new(m, start + len, x->start + x->len - start - len, true)); 
+     x->start = start; 
+     x->len = len; 
+     x->free = false; 
+     extent_link(m, x); 
+     return start; 
+ } 
+ 
+ //按放置策略分配len字节，从选中区段的低端切，失败返回-1 
+ Addr region_alloc(RegionMap* m, Addr len, FitPolicy fit) { 
+     if (len <= 0) return -1; 
+     Extent* x; 
+     switch (fit) { 
+     case FIT_BEST: x = region_best_fit(m, len); break; 
+     case FIT_WORST: x = region_worst_fit(m, len); break; 
+     default: x = region_first_fit(m, len); break; 
+     } 
+     return x ? region_carve(m, x, x->start, len) : -1; 
+ } 
+ 
+ //在指定地址分配，[start, start + len)必须落在同一个空闲区段内 
+ bool region_alloc_at(RegionMap* m, Addr start, Addr len) { 
+     Extent* x = region_find(m, start); 
+     if (!x || !x->free || len <= 0 || start + len > x->start + x->len) return false; 
+     region_carve(m, x, start, len); 
+     return true; 
+ } 
+ 
+ //归还[start, start + len)，必须落在同一个已用区段内，可以只归还区段中间的一部分； 
+ //归还的部分和左右相邻的空闲区段合并 
+ bool region_free(RegionMap* m, Addr start, Addr len) { 
+     Extent* x = region_find(m, start); 
+     if (!x || x->free || len <= 0 || start + len > x->start + x->len) return false; 
+     extent_unlink(m, x); 
+     if (x->start < start) extent_link(m, extent_new(m, x->start, start - x->start, false)); 
+     if (start + len < x->start + x->len) extent_link(m, extent_new(m, start + len, x->start + x->len - start - len, false)); 
+     x->start = start; 
+     x->len = len; 
+     x->free = true; 
+     Extent* prv = start > m->base ? region_find(m, start - 1) : NULL; 
+     if (prv && prv->free) { 
+         extent_unlink(m, prv); 
+         x->start = prv->start; 
+         x->len += prv->len; 
+         extent_delete(m, prv); 
+     } 
+     Extent* nxt = region_find(m, x->start + x->len); 
+     if (nxt && nxt->free) { 
+         extent_unlink(m, nxt); 
+         x->len += nxt->len; 
+         extent_delete(m, nxt); 
+     } 
+     extent_link(m, x); 
+     return true; 
+ } 
+ 
+ //检查不变量：区段无缝覆盖整个地址空间，没有相邻的空闲区段，max_free正确，尺寸树恰好是全部空闲区段 
+ typedef struct RegionCheck { 
+     Addr next;//下一个区段应有的起始地址 
+     bool prev_free; 
+     long count; 
+     long free_count; 
+     bool ok; 
+ } RegionCheck; 
+ 
+ Addr region_check_addr(Extent* t, RegionCheck* c) { 
+     if (!t) return 0; 
+     Addr ml = region_check_addr(t->l, c); 
+     if (t->start != c->next || t->len <= 0 || (t->free && c->prev_free)) c->ok = false; 
+     c->next = t->start + t->len; 
+     c->prev_free = t->free; 
+     c->count++; 
+     c->free_count += t->free; 
+     Addr mr = region_check_addr(t->r, c); 
+     Addr m = t->free ? t->len : 0; 
+     if (ml > m) m = ml; 
+     if (mr > m) m = mr; 
+     if (t->max_free != m) c->ok = false; 
+     return m; 
+ } 
+ 
+ long region_check_size(Extent* t, const Extent* lo, const Extent* hi, bool* ok) { 
+     if (!t) return 0; 
+     if (!t->free) *ok = false; 
+     if (lo && !size_less(lo, t->len, t->start)) *ok = false; 
+     if (hi && !size_less(t, hi->len, hi->start)) *ok = false; 
+     return 1 + region_check_size(t->sl, lo, t, ok) + region_check_size(t->sr, t, hi, ok); 
+ } 
+ 
+ bool region_check(RegionMap* m) { 
+     RegionCheck c = { m->base, false, 0, 0, true }; 
+     region_check_addr(m->root, &c); 
+     if (c.next != m->base + m->size || c.count != m->extents) c.ok = false; 
+     if (region_check_size(m->size_root, NULL, NULL, &c.ok) != c.free_count) c.ok = false; 
+     return c.ok; 
+ } 
+ 
+ int extent_depth(Extent* t) { 
+     if (!t) return 0; 
+     int a = extent_depth(t->l), b = extent_depth(t->r); 
+     return 1 + (a > b ? a : b); 
+ } 
+ 
+ //对数均匀分布的大区域请求，按1MB对齐 
+ Addr region_rand_len(unsigned int* r) { 
+     int bits = Region_Min_Bits + (int)(xorshift32(r) % (Region_Max_Bits - Region_Min_Bits + 1)); 
+     Addr len = ((Addr)1 << bits) + (Addr)(xorshift32(r) % 1024) * ((Addr)1 << (bits - 10)); 
+     return len >> Region_Min_Bits << Region_Min_Bits; 
+ } 
+ 
+ typedef struct RegionResult { 
+     double ns_per_op; 
+     double steps_per_op; 
+     long fails; 
+     long partial_frees; 
+     long placed_at; 
+     long max_extents; 
+     int depth; 
+     double frag;//1 - 最大空闲 / 空闲总量，结束时 
+     bool consistent; 
+ } RegionResult; 
+ 
+ //随机大区域负载：按策略分配、整段或部分归还、偶尔在指定地址分配；check为真时每步检查不变量 
+ RegionResult region_run(FitPolicy fit, long ops, unsigned int seed, bool check) { 
+     RegionMap m; 
+     region_init(&m, 0, (Addr)1 << Region_Arena_Bits, seed * 2654435761u + 1); 
+     unsigned int wrng = seed + 0x9e3779b9u; 
+     Addr* live_start = (Addr*)malloc(sizeof(Addr) * Region_Live); 
+     Addr* live_len = (Addr*)malloc(sizeof(Addr) * Region_Live); 
+     if (!live_start || !live_len) { perror("malloc"); exit(1); } 
+     int live_n = 0; 
+     RegionResult res = { 0 }; 
+     res.consistent = true; 
+     long long t0 = now_ns(); 
+     for (long i = 0; i < ops; ++i) { 
+         int r = (int)(xorshift32(&wrng) % 100); 
+         if (live_n < Region_Live && (live_n == 0 || r < 55)) { 
+             Addr len = region_rand_len(&wrng); 
+             Addr at = -1; 
+             if (r < 5) { 
+                 //在随机地址上分配，只有那里恰好空闲才成功 
+                 Addr want = (Addr)(((unsigned long long)xorshift32(&wrng) << 22) % ((unsigned long long)1 << Region_Arena_Bits)); 
+                 if (region_alloc_at(&m, want, len)) { at = want; res.placed_at++; } 
+             } 
+             if (at < 0) at = region_alloc(&m, len, fit); 
+             if (at >= 0) { 
+                 live_start[live_n] = at; 
+                 live_len[live_n] = len; 
+                 live_n++; 
+             } 
+             else { 
+                 res.fails++; 
+             } 
+         } 
+         else { 
+             int k = (int)(xorshift32(&wrng) % live_n); 
+             if (live_len[k] >= ((Addr)4 << Region_Min_Bits) && r >= 90) { 
+                 //归还区域的前半部分，剩下的后半部分仍然持有 
+                 Addr half = live_len[k] / 2 >> Region_Min_Bits << Region_Min_Bits; 
+                 region_free(&m, live_start[k], half); 
+                 live_start[k] += half; 
+                 live_len[k] -= half; 
+                 res.partial_frees++; 
+             } 
+             else { 
+                 region_free(&m, live_start[k], live_len[k]); 
+                 live_start[k] = live_start[--live_n]; 
+                 live_len[k] = live_len[live_n]; 
+             } 
+         } 
+         if (m.extents > res.max_extents) res.max_extents = m.extents; 
+         if (check && !region_check(&m)) res.consistent = false; 
+     } 
+     long long elapsed = now_ns() - t0; 
+     res.ns_per_op = ops ? (double)elapsed / ops : 0; 
+     res.steps_per_op = ops ? (double)m.steps / ops : 0; 
+     res.depth = extent_depth(m.root); 
+     Addr total = 0; 
+     for (Extent* x = region_first_fit(&m, 1); x; ) { 
+         total += x->len; 
+         x = region_find(&m, x->start + x->len); 
+         while (x && !x->free) x = region_find(&m, x->start + x->len); 
+     } 
+     res.frag = total ? 1.0 - (double)m.root->max_free / total : 0; 
+     if (!region_check(&m)) res.consistent = false; 
+     free(live_start); 
+     free(live_len); 
+     region_destroy(&m); 
+     return res; 
+ } 
+ 
+ //大区域管理器入口：4TB地址空间上1MB到64GB的区域，比较三种放置策略 
+ int run_regions(int argc, char* argv[]) { 
+     long ops = argc >= 3 ? atol(argv[2]) : 1000000; 
+     unsigned int seed = argc >= 4 ? (unsigned int)atoi(argv[3]) : (unsigned int)time(NULL); 
+     bool check = argc >= 5 && strcmp(argv[4], "check") == 0; 
+     static const FitPolicy fits[] = { FIT_FIRST, FIT_BEST, FIT_WORST }; 
+     printf("———————————— 大区域管理器（区间树） ————————————\n"); 
+     printf("随机种子: %u, 操作数: %ld, 地址空间 %lldGB, 请求 %lldMB-%lldGB, 最多同时持有 %d 个区域%s\n", 
+            seed, ops, ((Addr)1 << Region_Arena_Bits) >> 30, ((Addr)1 << Region_Min_Bits) >> 20, 
+            ((Addr)1 << Region_Max_Bits) >> 30, Region_Live, check ? ", 每步检查不变量" : ""); 
+     printf("策略               ns/op 每次操作访问结点 最多区段数 树高 结束时外部碎片 分配失败 部分归还 指定地址分配 一致性\n"); 
+     for (int i = 0; i < (int)(sizeof(fits) / sizeof(fits[0])); ++i) { 
+         RegionResult r = region_run(fits[i], ops, seed, check); 
+         printf("%-18s %6.0f %16.1f %10ld %4d %13.2f%% %8ld %8ld %12ld %s\n", fit_name[fits[i]], r.ns_per_op, 
+                r.steps_per_op, r.max_extents, r.depth, r.frag * 100, r.fails, r.partial_frees, r.placed_at, 
+                r.consistent ? "通过" : "失败"); 
+     } 
+     return 0; 
  } 
  
  int main(int argc, char* argv[]) { 
+     if (argc >= 2 && strcmp(argv[1], "mt") == 0) return run_mt(argc, argv); 
+     if (argc >= 2 && strcmp(argv[1], "slab") == 0) return run_slab(argc, argv); 
+     if (argc >= 2 && strcmp(argv[1], "coalesce") == 0) return run_coalesce(argc, argv); 
+     if (argc >= 2 && strcmp(argv[1], "fits") == 0) return run_fits(argc, argv); 
+     if (argc >= 2 && strcmp(argv[1], "mc") == 0) return run_mc(argc, argv); 
+     if (argc >= 2 && strcmp(argv[1], "gentrace") == 0) return run_gentrace(argc, argv); 
+     if (argc >= 2 && strcmp(argv[1], "bench") == 0) return run_bench(argc, argv); 
+     if (argc >= 2 && strcmp(argv[1], "lifetime") == 0) return run_lifetime(argc, argv); 
+     if (argc >= 2 && strcmp(argv[1], "classes") == 0) return run_classes(argc, argv); 
+     if (argc >= 2 && strcmp(argv[1], "paging") == 0) return run_paging(argc, argv); 
+     if (argc >= 2 && strcmp(argv[1], "regions") == 0) return run_regions(argc, argv); 
      unsigned int seed; 
      if (argc >= 2) seed = (unsigned int)atoi(argv[1]); 
      else seed = (unsigned int)time(NULL); 
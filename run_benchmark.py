@@ -235,6 +235,20 @@ def main():
         message_bits=70,
     ))
     
+    results.append(measure(
+        "Hamming(15,11) 分块 McEliece（系统形式）",
+        lambda: HammingMcEliece(L=10, errors_per_block=1, systematic=True),
+        trials=trials,
+        message_bits=110,
+    ))
+    
+    results.append(measure(
+        "BCH(15,7,t=2) 分块 McEliece（系统形式）",
+        lambda: BCHMcEliece(L=10, errors_per_block=2, systematic=True),
+        trials=trials,
+        message_bits=70,
+    ))
+    
     # 在最后统一生成图表
     plot_results(results)
 